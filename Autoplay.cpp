@@ -0,0 +1,87 @@
+#include "Autoplay.h"
+
+#include <algorithm>
+
+#include "Replay.h"
+
+
+unsigned char Autoplayer::decide(const GameWorld& world, float dt) {
+	decisions++;
+	uint32_t window = static_cast<uint32_t>(lookahead / dt + 0.5f);
+	uint32_t total = window + std::max(1u, static_cast<uint32_t>(playout / dt + 0.5f));
+	uint32_t every = std::max(interval, 1u);
+
+	scratch = world;
+	Outcome wait = { 0, total, 0 };
+	Outcome best = wait;
+	unsigned char bestInput = AUTOPLAY_WAIT;
+	uint32_t bestDelay = 0;
+	bool planned = false;
+
+	for (uint32_t t = 0; t < total && scratch.gameState == 0; t++) {
+		if (t < window && t % every == 0) {
+			// Cheapest commitment first; presses the player would ignore are skipped
+			const unsigned char candidates[2] = { INPUT_DUCK, INPUT_JUMP };
+			for (unsigned char input : candidates) {
+				if ((input == INPUT_DUCK && scratch.player.isDucking) || (input == INPUT_JUMP && scratch.player.isJumping)) {
+					continue;
+				}
+				Outcome o = playOut(world, input, t, total, wait, dt);
+				if (!planned || better(o, best) || (!better(best, o) && t > bestDelay)) { // Equal plans: the later press
+					best = o;
+					bestInput = input;
+					bestDelay = t;
+					planned = true;
+				}
+			}
+		}
+		stepAndScore(scratch, t, wait, dt);
+	}
+	wait.scoreGained = scratch.gameScore - world.gameScore;
+
+	if (planned && bestDelay == 0 && better(best, wait)) {
+		return bestInput;
+	}
+	return AUTOPLAY_WAIT; // Nothing to do, or a later press is better
+}
+
+unsigned char Autoplayer::poll(const GameWorld& world, float dt) {
+	if (world.gameState != 0 || world.tick % std::max(interval, 1u) != 0) {
+		return AUTOPLAY_WAIT;
+	}
+	return decide(world, dt);
+}
+
+Autoplayer::Outcome Autoplayer::playOut(const GameWorld& world, unsigned char input, uint32_t t, uint32_t total,
+	Outcome sofar, float dt) {
+	branch = scratch;
+	branch.applyInput(input);
+	for (; t < total && branch.gameState == 0; t++) {
+		stepAndScore(branch, t, sofar, dt);
+	}
+	sofar.scoreGained = branch.gameScore - world.gameScore;
+	rollouts++;
+	return sofar;
+}
+
+void Autoplayer::stepAndScore(GameWorld& w, uint32_t t, Outcome& o, float dt) {
+	int before = w.hearts;
+	w.step(dt);
+	simulatedTicks++;
+	if (w.hearts < before) {
+		if (o.heartsLost == 0) {
+			o.firstHit = t;
+		}
+		o.heartsLost += before - w.hearts;
+	}
+}
+
+bool Autoplayer::better(const Outcome& a, const Outcome& b) {
+	if (a.heartsLost != b.heartsLost) {
+		return a.heartsLost < b.heartsLost;
+	}
+	if (a.firstHit != b.firstHit) {
+		return a.firstHit > b.firstHit;
+	}
+	return a.scoreGained > b.scoreGained;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GameWorld.h"
+
+// Lookahead autoplayer. Each decision copies the world into a scratch world and
+// plays it forward with no input; at every decision point within the lookahead
+// window it branches a second copy, presses duck or jump there, and plays that
+// branch out to the same end. The plan that loses the fewest hearts wins; ties
+// go to the later first hit, then the higher score, then to the later press.
+// Only a winning plan that presses now sends input, and only if it beats doing
+// nothing at all, so the bot waits for the last good moment and re-plans at the
+// next decision.
+//
+// The copies reuse the scratch world's storage, so once it has grown to the
+// live world's size a decision allocates nothing. Choices depend only on the
+// world, so an autoplayed run is reproducible from its seed, and its inputs can
+// be recorded into a Replay like key presses.
+
+const unsigned char AUTOPLAY_WAIT = 0; // decide() result when no input is worth sending
+
+class Autoplayer {
+public:
+	float lookahead = 0.5f; // Seconds ahead a press may be planned
+	float playout = 1.5f;   // Seconds every plan is played past the window; one full jump
+	uint32_t interval = 4;  // Steps between decisions in poll(), and between branch points
+	GameWorld scratch;      // The no-input path
+	GameWorld branch;       // One plan's press and what follows it
+
+	// Counters for benchmarks and soak runs
+	uint64_t decisions = 0;
+	uint64_t rollouts = 0;
+	uint64_t simulatedTicks = 0;
+
+	unsigned char decide(const GameWorld& world, float dt = SIM_STEP); // INPUT_JUMP, INPUT_DUCK or AUTOPLAY_WAIT
+	unsigned char poll(const GameWorld& world, float dt = SIM_STEP);   // decide() every interval ticks, AUTOPLAY_WAIT between
+
+private:
+	struct Outcome {
+		int heartsLost;
+		uint32_t firstHit; // Steps from the decision; the plan's length if nothing hit
+		int scoreGained;
+	};
+
+	// Press input on a copy of the no-input path at step t, whose outcome so far is
+	// sofar, and play it out to step total
+	Outcome playOut(const GameWorld& world, unsigned char input, uint32_t t, uint32_t total, Outcome sofar, float dt);
+	void stepAndScore(GameWorld& w, uint32_t t, Outcome& o, float dt);
+	static bool better(const Outcome& a, const Outcome& b); // Strictly
+};
@@ -0,0 +1,262 @@
+#include "BatchRenderer.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "GLBuffers.h"
+
+
+BatchRenderer::BatchRenderer()
+	: packedColor(0xffffffffu), linePixels(1.0f), pointPixels(1.0f), pixelX(1.0f), pixelY(1.0f),
+	mode(GL_TRIANGLES), buffer(0), bufferState(0) {
+	current = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+	vertices.reserve(4096);
+	shape.reserve(128);
+}
+
+BatchRenderer::~BatchRenderer() {
+	if (buffer != 0) {
+		bufferApi()->deleteBuffers(1, &buffer);
+	}
+}
+
+void BatchRenderer::startFrame() {
+	GLfloat projection[16];
+	GLint viewport[4];
+	glGetFloatv(GL_PROJECTION_MATRIX, projection);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (projection[0] != 0.0f && projection[5] != 0.0f && viewport[2] > 0 && viewport[3] > 0) {
+		pixelX = std::fabs(2.0f / (projection[0] * viewport[2]));
+		pixelY = std::fabs(2.0f / (projection[5] * viewport[3]));
+	}
+	current = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+	stack.clear();
+	drawCalls = 0;
+}
+
+void BatchRenderer::flush() {
+	flushedVertices = vertices.size();
+	if (vertices.empty()) {
+		return;
+	}
+	const char* base = reinterpret_cast<const char*>(vertices.data());
+	const BufferApi* gl = useBuffer() ? bufferApi() : nullptr;
+	if (gl) {
+		// Re-specifying the whole store each time lets the driver orphan last frame's instead of waiting on it
+		gl->bindBuffer(GL_ARRAY_BUFFER, buffer);
+		gl->bufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(vertices.size() * sizeof(BatchVertex)), base, GL_STREAM_DRAW);
+		base = nullptr; // Pointers below are offsets into the buffer
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	drawArrays(base, vertices.size());
+	glDisable(GL_BLEND);
+
+	if (gl) {
+		gl->bindBuffer(GL_ARRAY_BUFFER, 0); // Other client-side arrays read from memory again
+	}
+	vertices.clear();
+	drawCalls++;
+}
+
+void BatchRenderer::drawArrays(const char* base, size_t count) {
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), base);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), base + offsetof(BatchVertex, color));
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(count));
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+bool BatchRenderer::useBuffer() {
+	if (!allowBuffers) {
+		return false;
+	}
+	if (bufferState == 0) {
+		bufferState = -1;
+		if (const BufferApi* gl = bufferApi()) {
+			gl->genBuffers(1, &buffer);
+			bufferState = (buffer != 0) ? 1 : -1;
+		}
+	}
+	return bufferState > 0;
+}
+
+
+void BatchRenderer::color(float r, float g, float b, float a) {
+	const unsigned char bytes[4] = {
+		static_cast<unsigned char>(std::fmin(std::fmax(r, 0.0f), 1.0f) * 255.0f + 0.5f),
+		static_cast<unsigned char>(std::fmin(std::fmax(g, 0.0f), 1.0f) * 255.0f + 0.5f),
+		static_cast<unsigned char>(std::fmin(std::fmax(b, 0.0f), 1.0f) * 255.0f + 0.5f),
+		static_cast<unsigned char>(std::fmin(std::fmax(a, 0.0f), 1.0f) * 255.0f + 0.5f)
+	};
+	memcpy(&packedColor, bytes, sizeof(packedColor));
+}
+
+void BatchRenderer::lineWidth(float pixels) {
+	linePixels = pixels;
+}
+
+void BatchRenderer::pointSize(float pixels) {
+	pointPixels = pixels;
+}
+
+
+void BatchRenderer::push() {
+	stack.push_back(current);
+}
+
+void BatchRenderer::pop() {
+	if (!stack.empty()) {
+		current = stack.back();
+		stack.pop_back();
+	}
+}
+
+void BatchRenderer::translate(float x, float y) {
+	current.tx += current.a * x + current.c * y;
+	current.ty += current.b * x + current.d * y;
+}
+
+void BatchRenderer::scale(float sx, float sy) {
+	current.a *= sx; current.b *= sx;
+	current.c *= sy; current.d *= sy;
+}
+
+void BatchRenderer::rotate(float degrees) {
+	float r = degrees * 0.017453293f;
+	float cs = cosf(r), sn = sinf(r);
+	Transform t = current;
+	current.a = t.a * cs + t.c * sn;
+	current.b = t.b * cs + t.d * sn;
+	current.c = t.c * cs - t.a * sn;
+	current.d = t.d * cs - t.b * sn;
+}
+
+void BatchRenderer::rotateY(float degrees) {
+	scale(cosf(degrees * 0.017453293f), 1.0f); // Depth is dropped, so only x foreshortens
+}
+
+
+void BatchRenderer::begin(GLenum m) {
+	mode = m;
+	shape.clear();
+}
+
+void BatchRenderer::vertex(float x, float y) {
+	shape.push_back(current.a * x + current.c * y + current.tx);
+	shape.push_back(current.b * x + current.d * y + current.ty);
+}
+
+// The instance transform is folded into the current one, so each point costs two multiply-adds per axis
+void BatchRenderer::appendShape(const std::vector<float>& unit, float cx, float cy, float rx, float ry) {
+	float a = current.a * rx, b = current.b * rx, c = current.c * ry, d = current.d * ry;
+	float tx = current.a * cx + current.c * cy + current.tx;
+	float ty = current.b * cx + current.d * cy + current.ty;
+	for (size_t i = 0; i + 1 < unit.size(); i += 2) {
+		shape.push_back(a * unit[i] + c * unit[i + 1] + tx);
+		shape.push_back(b * unit[i] + d * unit[i + 1] + ty);
+	}
+}
+
+void BatchRenderer::appendPixelRects(const std::vector<float>& rects, float x, float y) {
+	float ox = current.a * x + current.c * y + current.tx;
+	float oy = current.b * x + current.d * y + current.ty;
+	for (size_t i = 0; i + 3 < rects.size(); i += 4) {
+		float x0 = ox + rects[i] * pixelX, y0 = oy + rects[i + 1] * pixelY;
+		float x1 = ox + rects[i + 2] * pixelX, y1 = oy + rects[i + 3] * pixelY;
+		const float corners[8] = { x0, y0, x1, y0, x1, y1, x0, y1 };
+		emitQuad(corners);
+	}
+}
+
+void BatchRenderer::end() {
+	size_t n = shape.size() / 2;
+	switch (mode) {
+	case GL_TRIANGLES:
+		for (size_t i = 0; i + 3 <= n; i += 3) {
+			emitTriangle(i, i + 1, i + 2);
+		}
+		break;
+	case GL_QUADS:
+		for (size_t i = 0; i + 4 <= n; i += 4) {
+			emitTriangle(i, i + 1, i + 2);
+			emitTriangle(i, i + 2, i + 3);
+		}
+		break;
+	case GL_POLYGON:
+	case GL_TRIANGLE_FAN:
+		for (size_t i = 1; i + 1 < n; i++) {
+			emitTriangle(0, i, i + 1);
+		}
+		break;
+	case GL_TRIANGLE_STRIP:
+		for (size_t i = 0; i + 2 < n; i++) {
+			if (i & 1) {
+				emitTriangle(i + 1, i, i + 2);
+			}
+			else {
+				emitTriangle(i, i + 1, i + 2);
+			}
+		}
+		break;
+	case GL_LINES:
+		for (size_t i = 0; i + 2 <= n; i += 2) {
+			emitLine(shape[2 * i], shape[2 * i + 1], shape[2 * i + 2], shape[2 * i + 3]);
+		}
+		break;
+	case GL_LINE_STRIP:
+	case GL_LINE_LOOP:
+		for (size_t i = 0; i + 1 < n; i++) {
+			emitLine(shape[2 * i], shape[2 * i + 1], shape[2 * i + 2], shape[2 * i + 3]);
+		}
+		if (mode == GL_LINE_LOOP && n > 2) {
+			emitLine(shape[2 * n - 2], shape[2 * n - 1], shape[0], shape[1]);
+		}
+		break;
+	case GL_POINTS: {
+		float hx = 0.5f * pointPixels * pixelX, hy = 0.5f * pointPixels * pixelY;
+		for (size_t i = 0; i < n; i++) {
+			float x = shape[2 * i], y = shape[2 * i + 1];
+			const float corners[8] = { x - hx, y - hy, x + hx, y - hy, x + hx, y + hy, x - hx, y + hy };
+			emitQuad(corners);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	shape.clear();
+}
+
+
+void BatchRenderer::emit(float x, float y) {
+	BatchVertex v = { x, y, packedColor };
+	vertices.push_back(v);
+}
+
+void BatchRenderer::emitTriangle(size_t i0, size_t i1, size_t i2) {
+	emit(shape[2 * i0], shape[2 * i0 + 1]);
+	emit(shape[2 * i1], shape[2 * i1 + 1]);
+	emit(shape[2 * i2], shape[2 * i2 + 1]);
+}
+
+// A quad linePixels wide, measured across the segment in screen pixels
+void BatchRenderer::emitLine(float x0, float y0, float x1, float y1) {
+	float dx = (x1 - x0) / pixelX, dy = (y1 - y0) / pixelY;
+	float length = std::sqrt(dx * dx + dy * dy);
+	if (length <= 0.0f) {
+		return;
+	}
+	float half = 0.5f * linePixels / length;
+	float nx = -dy * half * pixelX, ny = dx * half * pixelY;
+	const float corners[8] = { x0 + nx, y0 + ny, x1 + nx, y1 + ny, x1 - nx, y1 - ny, x0 - nx, y0 - ny };
+	emitQuad(corners);
+}
+
+void BatchRenderer::emitQuad(const float* p) {
+	emit(p[0], p[1]); emit(p[2], p[3]); emit(p[4], p[5]);
+	emit(p[0], p[1]); emit(p[4], p[5]); emit(p[6], p[7]);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glut.h>
+
+// Batched replacement for immediate-mode drawing. The calls mirror the GL ones
+// they replace (begin/vertex/end, color, push/translate/pop, line width, point
+// size), but only append to a CPU vertex array: every primitive becomes colored
+// triangles in submission order, lines and points included, expanded to their
+// pixel width at the current viewport. flush() hands the whole array to GL in
+// one streaming buffer upload and one draw call, so a frame costs a couple of
+// driver calls instead of one per vertex.
+//
+// Vertex buffers are GL 1.5, beyond what opengl32.dll exports on Windows, so
+// their entry points are looked up at the first flush; without them flush()
+// draws straight from the CPU array with client-side vertex arrays.
+
+struct BatchVertex {
+	float x, y;
+	uint32_t color; // RGBA bytes in memory order
+};
+
+class BatchRenderer {
+public:
+	std::vector<BatchVertex> vertices; // Triangles not yet flushed, in draw order
+
+	// Stats of the last flush
+	size_t flushedVertices = 0;
+	size_t drawCalls = 0; // Since startFrame()
+
+	bool allowBuffers = true; // False keeps flush() on client-side arrays
+
+	BatchRenderer();
+	~BatchRenderer();
+
+	void startFrame(); // Pixel size from the current projection and viewport; resets the transform and stats
+	void flush();      // Draw everything appended so far, keeping the storage for the next batch
+
+	// One glDrawArrays of count BatchVertex triangles at base: client memory, or an
+	// offset into the bound array buffer. Leaves blending to the caller.
+	static void drawArrays(const char* base, size_t count);
+
+	// Current state, as the matching GL calls would set it
+	void color(float r, float g, float b, float a = 1.0f);
+	void lineWidth(float pixels);
+	void pointSize(float pixels);
+
+	// 2D transform stack applied to every vertex
+	void push();
+	void pop();
+	void translate(float x, float y);
+	void scale(float sx, float sy);
+	void rotate(float degrees);  // About the z-axis
+	void rotateY(float degrees); // About the y-axis, as an orthographic projection shows it
+
+	// GL_TRIANGLES, GL_QUADS, GL_POLYGON (convex, fanned from the first vertex),
+	// GL_TRIANGLE_FAN, GL_TRIANGLE_STRIP, GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP, GL_POINTS
+	void begin(GLenum mode);
+	void vertex(float x, float y);
+	void end();
+
+	// vertex() for each x, y pair of a cached unit shape, scaled by rx, ry and moved to cx, cy
+	void appendShape(const std::vector<float>& unit, float cx, float cy, float rx, float ry);
+
+	// Axis-aligned rectangles given as x0, y0, x1, y1 in pixels from the point x, y,
+	// the way glBitmap places its pixels from the raster position
+	void appendPixelRects(const std::vector<float>& rects, float x, float y);
+
+private:
+	struct Transform {
+		float a, b, c, d, tx, ty; // x' = a x + c y + tx, y' = b x + d y + ty
+	};
+
+	std::vector<Transform> stack;
+	Transform current;
+	uint32_t packedColor;
+	float linePixels, pointPixels;
+	float pixelX, pixelY; // World units per pixel
+
+	GLenum mode;
+	std::vector<float> shape; // Transformed vertices of the primitive being built
+
+	GLuint buffer;
+	int bufferState; // 0 not checked yet, 1 available, -1 unavailable
+
+	void emit(float x, float y);
+	void emitTriangle(size_t i0, size_t i1, size_t i2);
+	void emitLine(float x0, float y0, float x1, float y1);
+	void emitQuad(const float* corners); // Four corners in fan order
+	bool useBuffer();
+};
@@ -0,0 +1,175 @@
+#include "BatchRunner.h"
+
+#include "Autoplay.h"
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+// One worker's share of the runs
+struct WorkQueue {
+	std::mutex lock;
+	std::deque<uint32_t> runs;
+
+	bool popBack(uint32_t& run) {
+		std::lock_guard<std::mutex> guard(lock);
+		if (runs.empty()) {
+			return false;
+		}
+		run = runs.back();
+		runs.pop_back();
+		return true;
+	}
+
+	bool stealFront(uint32_t& run) {
+		std::lock_guard<std::mutex> guard(lock);
+		if (runs.empty()) {
+			return false;
+		}
+		run = runs.front();
+		runs.pop_front();
+		return true;
+	}
+};
+
+
+RunSummary BatchRunner::simulate(const BatchConfig& config, uint32_t run) {
+	GameWorld world;
+	world.rng.seed(config.seed, static_cast<uint64_t>(run) * 2);
+	world.spawnObstacleTime = config.spawnObstacleTime;
+	world.spawnCollectableTime = config.spawnCollectableTime;
+	world.spawnPowerUpTime = config.spawnPowerUpTime;
+	for (int lane = 0; lane < SPAWN_LANES; lane++) {
+		world.spawns.separation[lane] = config.spawnSeparation;
+	}
+	world.speed = config.startSpeed;
+	world.originalSpeed = config.startSpeed;
+	world.speedIncreaseInterval = config.speedIncreaseInterval;
+	world.speedIncrement = config.speedIncrement;
+	world.restartSpawns(); // Patterns from this run's seed, validated against this config; generated inline
+
+	Random input(config.seed, static_cast<uint64_t>(run) * 2 + 1);
+	Autoplayer bot;
+	bot.lookahead = config.autoplayLookahead;
+	int startHearts = world.hearts;
+	unsigned char cause = CAUSE_NONE;
+
+	while (world.gameState == 0 && world.tick < config.maxTicks) {
+		if (config.autoplayLookahead > 0.0f) {
+			unsigned char press = bot.poll(world, config.dt);
+			if (press != AUTOPLAY_WAIT) {
+				world.applyInput(press);
+			}
+		}
+		else {
+			float roll = input.nextFloat();
+			if (roll < config.jumpChance) {
+				world.applyInput(INPUT_JUMP);
+			}
+			else if (roll < config.jumpChance + config.duckChance) {
+				world.applyInput(INPUT_DUCK);
+			}
+		}
+		world.step(config.dt);
+
+		for (const Contact& c : world.contacts) {
+			if (c.type == CONTACT_OBSTACLE) {
+				cause = world.player.isJumping ? CAUSE_JUMPING : world.player.isDucking ? CAUSE_DUCKING : CAUSE_RUNNING;
+			}
+		}
+	}
+
+	RunSummary summary;
+	summary.score = world.gameScore;
+	summary.ticks = world.tick;
+	summary.heartsLost = static_cast<uint8_t>(startHearts - world.hearts);
+	summary.outcome = (world.gameState == 2) ? RUN_WON : (world.gameState == 1) ? RUN_LOST : RUN_TIMEOUT;
+	summary.cause = (summary.outcome == RUN_LOST) ? cause : CAUSE_NONE;
+	return summary;
+}
+
+
+void BatchRunner::run(uint32_t runs, unsigned threads) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	if (threads == 0) {
+		threads = 1; // Unknown core count
+	}
+	results.assign(runs, RunSummary());
+
+	// Deal the runs out in contiguous blocks; stealing evens out the rest
+	std::vector<WorkQueue> queues(threads);
+	for (uint32_t r = 0; r < runs; r++) {
+		queues[static_cast<size_t>(r) * threads / runs].runs.push_back(r);
+	}
+
+	auto worker = [this, &queues, threads](unsigned self) {
+		uint32_t run;
+		for (;;) {
+			bool found = queues[self].popBack(run);
+			for (unsigned i = 1; !found && i < threads; i++) {
+				found = queues[(self + i) % threads].stealFront(run);
+			}
+			if (!found) {
+				return; // Nothing is ever added, so empty everywhere means done
+			}
+			results[run] = simulate(config, run);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; t++) {
+		pool.emplace_back(worker, t);
+	}
+	worker(0);
+	for (std::thread& t : pool) {
+		t.join();
+	}
+}
+
+
+// Columnar file: "IRBT", u32 version, u32 run count, u32 column count, then per column
+// a u8 name length, the name, a u8 element size and the whole column. Host byte order.
+static void writeColumn(FILE* file, const char* name, const void* data, unsigned char elementSize, uint32_t count) {
+	unsigned char nameLength = static_cast<unsigned char>(strlen(name));
+	fwrite(&nameLength, 1, 1, file);
+	fwrite(name, 1, nameLength, file);
+	fwrite(&elementSize, 1, 1, file);
+	fwrite(data, elementSize, count, file);
+}
+
+bool BatchRunner::writeColumns(const char* path) const {
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	uint32_t count = static_cast<uint32_t>(results.size());
+
+	// Transpose the summaries into one array per field
+	std::vector<int32_t> score(count);
+	std::vector<uint32_t> ticks(count);
+	std::vector<uint8_t> heartsLost(count), outcome(count), cause(count);
+	for (uint32_t i = 0; i < count; i++) {
+		score[i] = results[i].score;
+		ticks[i] = results[i].ticks;
+		heartsLost[i] = results[i].heartsLost;
+		outcome[i] = results[i].outcome;
+		cause[i] = results[i].cause;
+	}
+
+	uint32_t header[3] = { 1, count, 5 };
+	fwrite("IRBT", 1, 4, file);
+	fwrite(header, sizeof(uint32_t), 3, file);
+	writeColumn(file, "score", score.data(), 4, count);
+	writeColumn(file, "ticks", ticks.data(), 4, count);
+	writeColumn(file, "hearts_lost", heartsLost.data(), 1, count);
+	writeColumn(file, "outcome", outcome.data(), 1, count);
+	writeColumn(file, "cause", cause.data(), 1, count);
+
+	bool ok = !ferror(file);
+	return (fclose(file) == 0) && ok;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "GameWorld.h"
+
+// Runs many independent GameWorlds across threads and collects one summary per
+// run. Each worker owns a deque of run indices; it takes work from the back of
+// its own deque and, when that runs dry, steals from the front of another
+// worker's, so a thread stuck with long games doesn't hold up the batch.
+// Results land in their run's slot, so the output doesn't depend on scheduling.
+
+// How a run ended
+const unsigned char RUN_WON = 0;     // The game clock ran out
+const unsigned char RUN_LOST = 1;    // Out of hearts
+const unsigned char RUN_TIMEOUT = 2; // Hit maxTicks first
+
+// What the player was doing when the fatal obstacle hit
+const unsigned char CAUSE_NONE = 0;
+const unsigned char CAUSE_RUNNING = 1;
+const unsigned char CAUSE_JUMPING = 2;
+const unsigned char CAUSE_DUCKING = 3;
+
+struct BatchConfig {
+	uint64_t seed = 1;       // Run i uses streams 2i (world) and 2i + 1 (input) of this seed
+	float dt = SIM_STEP;
+	uint32_t maxTicks = 100000;
+
+	// Tunables copied into every world
+	float spawnObstacleTime = 3.0f;
+	float spawnCollectableTime = 11.0f;
+	float spawnPowerUpTime = 13.0f;
+	float spawnSeparation = 0.5f; // Minimum gap between spawns of different kinds
+	float startSpeed = 0.01f;
+	int speedIncreaseInterval = 30;
+	float speedIncrement = 0.005f;
+
+	// Random input: chance per step of pressing jump / duck
+	float jumpChance = 0.02f;
+	float duckChance = 0.02f;
+
+	// Above 0, the lookahead autoplayer plays instead, planning this many seconds ahead
+	float autoplayLookahead = 0.0f;
+};
+
+struct RunSummary {
+	int32_t score;
+	uint32_t ticks;      // Steps survived
+	uint8_t heartsLost;
+	uint8_t outcome;     // RUN_*
+	uint8_t cause;       // CAUSE_*, CAUSE_NONE unless lost
+};
+
+class BatchRunner {
+public:
+	BatchConfig config;
+	std::vector<RunSummary> results; // Indexed by run
+
+	void run(uint32_t runs, unsigned threads); // threads == 0 uses every core
+	bool writeColumns(const char* path) const; // False on I/O failure
+
+	static RunSummary simulate(const BatchConfig& config, uint32_t run);
+};
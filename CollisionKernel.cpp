@@ -0,0 +1,264 @@
+#include "CollisionKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLLISION_KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang need per-function target attributes to emit AVX2 without building the
+// whole program for it; MSVC accepts the intrinsics anywhere.
+#if defined(COLLISION_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE2
+#endif
+
+
+// Reference test for obstacles [begin, count); same comparisons as the original per-obstacle check
+static void testScalar(const ObstacleHitboxes& b, size_t begin, size_t count, const PlayerBox& p, uint32_t* hitBits) {
+	for (size_t i = begin; i < count; i++) {
+		float x = b.x[i];
+		float swept = x + p.sweep; // Where the obstacle started this step
+		bool head = p.left < swept + b.headReach[i] && p.right > x &&
+			p.bottom < b.headTop[i] && p.top > b.headBottom[i];
+		bool body = p.left < swept && p.right > x - b.bodyReach[i] &&
+			p.bottom < b.bodyTop[i] && p.top > b.bodyBottom[i];
+		if (head || body) {
+			hitBits[i >> 5] |= 1u << (i & 31);
+		}
+	}
+}
+
+#if defined(COLLISION_KERNEL_X86)
+
+TARGET_SSE2
+static void testSse2(const ObstacleHitboxes& b, size_t count, const PlayerBox& p, uint32_t* hitBits) {
+	const __m128 left = _mm_set1_ps(p.left);
+	const __m128 right = _mm_set1_ps(p.right);
+	const __m128 bottom = _mm_set1_ps(p.bottom);
+	const __m128 top = _mm_set1_ps(p.top);
+	const __m128 sweep = _mm_set1_ps(p.sweep);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(b.x + i);
+		__m128 swept = _mm_add_ps(x, sweep);
+
+		__m128 head = _mm_and_ps(
+			_mm_and_ps(_mm_cmplt_ps(left, _mm_add_ps(swept, _mm_loadu_ps(b.headReach + i))), _mm_cmpgt_ps(right, x)),
+			_mm_and_ps(_mm_cmplt_ps(bottom, _mm_loadu_ps(b.headTop + i)), _mm_cmpgt_ps(top, _mm_loadu_ps(b.headBottom + i))));
+		__m128 body = _mm_and_ps(
+			_mm_and_ps(_mm_cmplt_ps(left, swept), _mm_cmpgt_ps(right, _mm_sub_ps(x, _mm_loadu_ps(b.bodyReach + i)))),
+			_mm_and_ps(_mm_cmplt_ps(bottom, _mm_loadu_ps(b.bodyTop + i)), _mm_cmpgt_ps(top, _mm_loadu_ps(b.bodyBottom + i))));
+
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_or_ps(head, body)));
+		hitBits[i >> 5] |= mask << (i & 31); // i is a multiple of 4, so the nibble never straddles a word
+	}
+	testScalar(b, i, count, p, hitBits);
+}
+
+TARGET_AVX2
+static void testAvx2(const ObstacleHitboxes& b, size_t count, const PlayerBox& p, uint32_t* hitBits) {
+	const __m256 left = _mm256_set1_ps(p.left);
+	const __m256 right = _mm256_set1_ps(p.right);
+	const __m256 bottom = _mm256_set1_ps(p.bottom);
+	const __m256 top = _mm256_set1_ps(p.top);
+	const __m256 sweep = _mm256_set1_ps(p.sweep);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(b.x + i);
+		__m256 swept = _mm256_add_ps(x, sweep);
+
+		__m256 head = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(left, _mm256_add_ps(swept, _mm256_loadu_ps(b.headReach + i)), _CMP_LT_OQ),
+				_mm256_cmp_ps(right, x, _CMP_GT_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(bottom, _mm256_loadu_ps(b.headTop + i), _CMP_LT_OQ),
+				_mm256_cmp_ps(top, _mm256_loadu_ps(b.headBottom + i), _CMP_GT_OQ)));
+		__m256 body = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(left, swept, _CMP_LT_OQ),
+				_mm256_cmp_ps(right, _mm256_sub_ps(x, _mm256_loadu_ps(b.bodyReach + i)), _CMP_GT_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(bottom, _mm256_loadu_ps(b.bodyTop + i), _CMP_LT_OQ),
+				_mm256_cmp_ps(top, _mm256_loadu_ps(b.bodyBottom + i), _CMP_GT_OQ)));
+
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_or_ps(head, body)));
+		hitBits[i >> 5] |= mask << (i & 31); // i is a multiple of 8, so the byte never straddles a word
+	}
+	testScalar(b, i, count, p, hitBits);
+}
+
+static bool cpuHasSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+	return true; // Part of the x86-64 baseline
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+		return false; // The OS doesn't save the YMM registers
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init(); // May run from a static initializer, before the runtime has probed the CPU
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+
+CollisionKernelLevel detectCollisionKernel() {
+#if defined(COLLISION_KERNEL_X86)
+	if (cpuHasAvx2()) {
+		return KERNEL_AVX2;
+	}
+	if (cpuHasSse2()) {
+		return KERNEL_SSE2;
+	}
+#endif
+	return KERNEL_SCALAR;
+}
+
+static CollisionKernelLevel kernelLevel = detectCollisionKernel();
+
+CollisionKernelLevel activeCollisionKernel() {
+	return kernelLevel;
+}
+
+void forceCollisionKernel(CollisionKernelLevel level) {
+	CollisionKernelLevel best = detectCollisionKernel();
+	kernelLevel = (level > best) ? best : level;
+}
+
+const char* collisionKernelName(CollisionKernelLevel level) {
+	switch (level) {
+	case KERNEL_AVX2: return "avx2";
+	case KERNEL_SSE2: return "sse2";
+	default: return "scalar";
+	}
+}
+
+void testObstacleHitboxes(const ObstacleHitboxes& boxes, size_t count, const PlayerBox& player, uint32_t* hitBits) {
+	memset(hitBits, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+	// A normal game's window holds one or two obstacles; don't wake the wide units for a tail
+	CollisionKernelLevel level = kernelLevel;
+	if (level == KERNEL_AVX2 && count < 8) {
+		level = KERNEL_SSE2;
+	}
+	if (level == KERNEL_SSE2 && count < 4) {
+		level = KERNEL_SCALAR;
+	}
+
+	switch (level) {
+#if defined(COLLISION_KERNEL_X86)
+	case KERNEL_AVX2:
+		testAvx2(boxes, count, player, hitBits);
+		break;
+	case KERNEL_SSE2:
+		testSse2(boxes, count, player, hitBits);
+		break;
+#endif
+	default:
+		testScalar(boxes, 0, count, player, hitBits);
+		break;
+	}
+}
+
+
+// Narrow the open interval (tMin, tMax) to the t where a0 + a1 * t > 0
+static void clipLinear(float a0, float a1, float& tMin, float& tMax) {
+	if (a1 > 0.0f) {
+		tMin = std::max(tMin, -a0 / a1);
+	}
+	else if (a1 < 0.0f) {
+		tMax = std::min(tMax, -a0 / a1);
+	}
+	else if (a0 <= 0.0f) {
+		tMax = -std::numeric_limits<float>::infinity(); // Never true
+	}
+}
+
+bool sweptBoxHit(const PlayerBox& start, const PlayerBox& end,
+	float left, float right, float bottom, float top, float sweep, float& toi) {
+	bool hitAtEnd = end.left < right && end.right > left && end.bottom < top && end.top > bottom;
+
+	// Target x range at t is [left, right] + sweep * (1 - t); the player's edges move linearly
+	float tMin = -std::numeric_limits<float>::infinity();
+	float tMax = std::numeric_limits<float>::infinity();
+	clipLinear(right + sweep - start.left, -sweep - (end.left - start.left), tMin, tMax);
+	clipLinear(start.right - left - sweep, sweep + (end.right - start.right), tMin, tMax);
+	clipLinear(top - start.bottom, -(end.bottom - start.bottom), tMin, tMax);
+	clipLinear(start.top - bottom, end.top - start.top, tMin, tMax);
+
+	if (tMin < tMax && tMin < 1.0f && tMax > 0.0f) {
+		toi = std::min(std::max(tMin, 0.0f), 1.0f);
+		return true;
+	}
+	if (hitAtEnd) {
+		toi = 1.0f; // Touching only at the very end, lost to rounding above
+		return true;
+	}
+	return false;
+}
+
+bool sweptCircleHit(float startX, float startY, float endX, float endY, float reach,
+	float cx, float cy, float sweep, float& toi) {
+	// Offset from the target's center to the player's at the end of the step
+	float ex = endX - cx;
+	float ey = endY - cy;
+	bool hitAtEnd = std::sqrt(ex * ex + ey * ey) < reach;
+
+	// Offset at t is e + w * (t - 1); the target moves left, the player wherever it went
+	float wx = (endX - startX) + sweep;
+	float wy = endY - startY;
+
+	// Solve |e + w u|^2 < reach^2 for u = t - 1 in [-1, 0]
+	float a = wx * wx + wy * wy;
+	float b = ex * wx + ey * wy;
+	float c = ex * ex + ey * ey - reach * reach;
+	if (a > 0.0f) {
+		float disc = b * b - a * c;
+		if (disc > 0.0f) {
+			float root = std::sqrt(disc);
+			float u0 = (-b - root) / a;
+			float u1 = (-b + root) / a;
+			if (u0 < 0.0f && u1 > -1.0f) {
+				toi = std::min(std::max(u0, -1.0f), 0.0f) + 1.0f;
+				return true;
+			}
+		}
+	}
+	if (hitAtEnd) {
+		toi = (a > 0.0f) ? 1.0f : 0.0f; // A still pair overlaps for the whole step
+		return true;
+	}
+	return false;
+}
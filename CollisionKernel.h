@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Batched player-vs-obstacle hitbox test. Each obstacle is two boxes (screw
+// head and body) precomputed at spawn relative to its scrolling x:
+//   head: [x, x + headReach] x [headBottom, headTop]
+//   body: [x - bodyReach, x] x [bodyBottom, bodyTop]
+// The kernel tests a contiguous run of obstacles against the player box and
+// sets bit i of hitBits when obstacle i overlaps it. The widest instruction
+// set the CPU supports (AVX2: 8 obstacles per iteration, SSE2: 4) is picked
+// at runtime; the scalar path is the reference and the fallback, and also
+// handles runs too short to fill one vector.
+
+enum CollisionKernelLevel {
+	KERNEL_SCALAR = 0,
+	KERNEL_SSE2 = 1,
+	KERNEL_AVX2 = 2
+};
+
+struct ObstacleHitboxes {
+	const float* x;
+	const float* headReach;
+	const float* headBottom;
+	const float* headTop;
+	const float* bodyReach;
+	const float* bodyBottom;
+	const float* bodyTop;
+};
+
+struct PlayerBox {
+	float left, right, bottom, top;
+	float sweep; // How far the obstacles scrolled left this step; stretches every hitbox right by it
+};
+
+// hitBits must hold at least (count + 31) / 32 words; it is fully overwritten.
+// With a nonzero sweep the test is conservative: it tests the region covered over
+// the whole step, so confirm candidates with sweptBoxHit.
+void testObstacleHitboxes(const ObstacleHitboxes& boxes, size_t count, const PlayerBox& player, uint32_t* hitBits);
+
+CollisionKernelLevel detectCollisionKernel(); // Best level this CPU supports
+CollisionKernelLevel activeCollisionKernel();
+void forceCollisionKernel(CollisionKernelLevel level); // Clamped to what the CPU supports
+const char* collisionKernelName(CollisionKernelLevel level);
+
+
+// Continuous tests over one step, t in [0, 1]. The player box moves linearly
+// from start to end while the target scrolls left by sweep, ending at the given
+// extent. On a hit, toi is the first t at which they overlap (0 if they already
+// did at the start of the step). An overlap at t = 1 uses the same comparisons
+// as a plain discrete test, so a zero-length step behaves exactly like one.
+bool sweptBoxHit(const PlayerBox& start, const PlayerBox& end,
+	float left, float right, float bottom, float top, float sweep, float& toi);
+
+// Circle variant: the player's center moves from (startX, startY) to (endX, endY),
+// and a hit is a center distance below reach
+bool sweptCircleHit(float startX, float startY, float endX, float endY, float reach,
+	float cx, float cy, float sweep, float& toi);
@@ -0,0 +1,296 @@
+#include "EntityStore.h"
+
+#include <algorithm>
+
+
+EntityRing::EntityRing(size_t capacity) {
+	size_t rounded = 1;
+	while (rounded < capacity) {
+		rounded <<= 1;
+	}
+	mask = rounded - 1;
+}
+
+size_t EntityRing::pushBack() {
+	size_t s = slot(live);
+	live++;
+	spawned++;
+	if (live > peak) {
+		peak = live;
+	}
+	return s;
+}
+
+void EntityRing::popFront() {
+	head = (head + 1) & mask;
+	live--;
+	despawned++;
+}
+
+void EntityRing::truncate(size_t n) {
+	live = n;
+}
+
+void EntityRing::clear() {
+	head = 0;
+	live = 0;
+}
+
+void EntityRing::assign(size_t n) {
+	head = 0;
+	live = n;
+	if (live > peak) {
+		peak = live;
+	}
+}
+
+size_t EntityRing::lowerBound(const std::vector<float>& x, float value) const {
+	size_t lo = 0;
+	size_t hi = live;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (x[slot(mid)] < value) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+int EntityRing::spans(size_t begin[2], size_t end[2]) const {
+	return spansOf(0, live, begin, end);
+}
+
+int EntityRing::spansOf(size_t first, size_t last, size_t begin[2], size_t end[2]) const {
+	if (first >= last) {
+		return 0;
+	}
+	size_t cap = mask + 1;
+	size_t start = slot(first);
+	size_t n = last - first;
+	begin[0] = start;
+	if (start + n <= cap) {
+		end[0] = start + n;
+		return 1;
+	}
+	end[0] = cap;
+	begin[1] = 0;
+	end[1] = start + n - cap;
+	return 2;
+}
+
+
+// Branch-free scroll of one x column over the live ranges of a ring
+static void scrollColumn(const EntityRing& ring, float* x, float speed) {
+	size_t begin[2], end[2];
+	int n = ring.spans(begin, end);
+	for (int s = 0; s < n; s++) {
+		for (size_t i = begin[s]; i < end[s]; i++) {
+			x[i] -= speed;
+		}
+	}
+}
+
+// Stable compaction over logical indices; moveEntity(from, to) copies every column
+template <typename MoveFn>
+static void compactRing(EntityRing& ring, std::vector<unsigned char>& flags, MoveFn moveEntity) {
+	size_t out = 0;
+	for (size_t i = 0; i < ring.count(); i++) {
+		size_t from = ring.slot(i);
+		if (flags[from] & ENTITY_REMOVE) {
+			continue;
+		}
+		if (out != i) {
+			moveEntity(from, ring.slot(out));
+		}
+		out++;
+	}
+	ring.truncate(out);
+}
+
+
+ObstacleStore::ObstacleStore(size_t capacity) : ring(capacity) {
+	size_t cap = ring.capacity();
+	x.assign(cap, 0.0f); y.assign(cap, 0.0f);
+	width.assign(cap, 0.0f); height.assign(cap, 0.0f);
+	flags.assign(cap, 0);
+	headReach.assign(cap, 0.0f); headBottom.assign(cap, 0.0f); headTop.assign(cap, 0.0f);
+	bodyReach.assign(cap, 0.0f); bodyBottom.assign(cap, 0.0f); bodyTop.assign(cap, 0.0f);
+	hitTime.assign(cap, 0.0f);
+}
+
+void ObstacleStore::clear() {
+	ring.clear();
+	maxWidth = 0.0f;
+}
+
+bool ObstacleStore::spawn(float initX, float initY, float w, float h) {
+	if (ring.full()) {
+		ring.dropped++;
+		return false;
+	}
+	maxWidth = std::max(maxWidth, w);
+	size_t s = ring.pushBack();
+	x[s] = initX;
+	y[s] = initY;
+	width[s] = w;
+	height[s] = h;
+	flags[s] = 0;
+	hitTime[s] = 0.0f;
+
+	// Screw head and body hitboxes, matching the shape drawn by drawObstacle
+	headReach[s] = w * 0.2f;
+	headBottom[s] = initY - h * 0.3f;
+	headTop[s] = initY + h * 0.5f;
+	bodyReach[s] = w * 1.5f;
+	bodyBottom[s] = initY + h * 0.05f;
+	bodyTop[s] = initY + h * 0.2f;
+	return true;
+}
+
+void ObstacleStore::move(float speed) {
+	scrollColumn(ring, x.data(), speed); // Move the obstacles leftwards towards the player
+}
+
+void ObstacleStore::overlapRange(float minX, float maxX, size_t& first, size_t& last) const {
+	// The head reaches 0.2 widths right of x, the body 1.5 widths left of it
+	first = ring.lowerBound(x, minX - maxWidth * 0.2f);
+	last = ring.lowerBound(x, maxX + maxWidth * 1.5f);
+}
+
+ObstacleHitboxes ObstacleStore::hitboxes(size_t beginSlot) const {
+	ObstacleHitboxes b;
+	b.x = x.data() + beginSlot;
+	b.headReach = headReach.data() + beginSlot;
+	b.headBottom = headBottom.data() + beginSlot;
+	b.headTop = headTop.data() + beginSlot;
+	b.bodyReach = bodyReach.data() + beginSlot;
+	b.bodyBottom = bodyBottom.data() + beginSlot;
+	b.bodyTop = bodyTop.data() + beginSlot;
+	return b;
+}
+
+void ObstacleStore::despawnBefore(float minX) {
+	// The screw head is the rightmost part of an obstacle
+	while (ring.count() > 0) {
+		size_t s = ring.slot(0);
+		if (x[s] + headReach[s] >= minX) {
+			break;
+		}
+		ring.popFront();
+	}
+}
+
+CollectableStore::CollectableStore(size_t capacity) : ring(capacity) {
+	size_t cap = ring.capacity();
+	x.assign(cap, 0.0f); y.assign(cap, 0.0f);
+	radius.assign(cap, 0.0f);
+	flags.assign(cap, 0);
+}
+
+void CollectableStore::clear() {
+	ring.clear();
+	maxRadius = 0.0f;
+}
+
+bool CollectableStore::spawn(float initX, float initY, float r) {
+	if (ring.full()) {
+		ring.dropped++;
+		return false;
+	}
+	maxRadius = std::max(maxRadius, r);
+	size_t s = ring.pushBack();
+	x[s] = initX;
+	y[s] = initY;
+	radius[s] = r;
+	flags[s] = 0;
+	return true;
+}
+
+void CollectableStore::move(float speed) {
+	scrollColumn(ring, x.data(), speed); // Move the collectibles to the left at the given speed
+}
+
+void CollectableStore::overlapRange(float minX, float maxX, size_t& first, size_t& last) const {
+	first = ring.lowerBound(x, minX - maxRadius);
+	last = ring.lowerBound(x, maxX + maxRadius);
+}
+
+void CollectableStore::despawnBefore(float minX) {
+	// The coin is drawn up to 1.5 radii wide
+	while (ring.count() > 0) {
+		size_t s = ring.slot(0);
+		if (x[s] + radius[s] * 1.5f >= minX) {
+			break;
+		}
+		ring.popFront();
+	}
+}
+
+void CollectableStore::removeMarked() {
+	compactRing(ring, flags, [this](size_t from, size_t to) {
+		x[to] = x[from];
+		y[to] = y[from];
+		radius[to] = radius[from];
+		flags[to] = flags[from];
+	});
+}
+
+
+PowerUpStore::PowerUpStore(size_t capacity) : ring(capacity) {
+	size_t cap = ring.capacity();
+	x.assign(cap, 0.0f); y.assign(cap, 0.0f);
+	size.assign(cap, 0.0f);
+	flags.assign(cap, 0);
+}
+
+void PowerUpStore::clear() {
+	ring.clear();
+	maxSize = 0.0f;
+}
+
+bool PowerUpStore::spawn(float initX, float initY, float s, bool speedPowerUp) {
+	if (ring.full()) {
+		ring.dropped++;
+		return false;
+	}
+	maxSize = std::max(maxSize, s);
+	size_t slotIndex = ring.pushBack();
+	x[slotIndex] = initX;
+	y[slotIndex] = initY;
+	size[slotIndex] = s;
+	flags[slotIndex] = speedPowerUp ? POWERUP_SPEED : 0;
+	return true;
+}
+
+void PowerUpStore::move(float speed) {
+	scrollColumn(ring, x.data(), speed); // Move the power-ups to the left at the given speed
+}
+
+void PowerUpStore::overlapRange(float minX, float maxX, size_t& first, size_t& last) const {
+	// Collision uses the square [x, x + size]
+	first = ring.lowerBound(x, minX - maxSize);
+	last = ring.lowerBound(x, maxX);
+}
+
+void PowerUpStore::despawnBefore(float minX) {
+	// The pill (two squares plus a semicircle cap) is the widest power-up, under 2 sizes
+	while (ring.count() > 0) {
+		size_t s = ring.slot(0);
+		if (x[s] + size[s] * 2.0f >= minX) {
+			break;
+		}
+		ring.popFront();
+	}
+}
+
+void PowerUpStore::removeMarked() {
+	compactRing(ring, flags, [this](size_t from, size_t to) {
+		x[to] = x[from];
+		y[to] = y[from];
+		size[to] = size[from];
+		flags[to] = flags[from];
+	});
+}
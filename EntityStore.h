@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "CollisionKernel.h"
+
+// Structure-of-arrays storage for the scrolling entities. Each type keeps its
+// hot fields (position, extent, flags) in contiguous columns so the per-tick
+// movement and collision passes stream through memory and vectorize; fields
+// that are only touched on a hit or an animation live in separate cold columns.
+//
+// Every entity spawns at the right edge and scrolls left at the same speed, so
+// spawn order is also x order. The columns are therefore fixed-capacity ring
+// queues: new entities go on the back, and entities that have scrolled out of
+// the viewport are popped off the front in O(1). Logical index i (0 = oldest)
+// lives in column slot slot(i).
+//
+// The same ordering gives a free sweep-and-prune broadphase: overlapRange()
+// binary-searches the x column for the window of entities whose extent can
+// reach a given x interval, so narrowphase tests only touch that window.
+
+// Obstacle flag bits
+const unsigned char OBSTACLE_HIT_PLAYER = 1 << 0; // Recently hit the player, ignored until a timer clears it at hitTime + 0.5 s
+
+// Power-up flag bits
+const unsigned char POWERUP_SPEED = 1 << 0; // Lightning (slow down); otherwise invincibility pill
+
+// Shared flag bit for entities picked up this tick
+const unsigned char ENTITY_REMOVE = 1 << 7;
+
+// Default ring capacity per entity type; a normal game never has more than a handful alive
+const size_t DEFAULT_ENTITY_CAPACITY = 256;
+
+
+// Fixed-capacity FIFO bookkeeping shared by the entity stores
+class EntityRing {
+public:
+	size_t peak = 0;                   // Most entities alive at once
+	unsigned long long spawned = 0;    // Entities pushed over the ring's lifetime
+	unsigned long long despawned = 0;  // Entities popped after leaving the viewport
+	unsigned long long dropped = 0;    // Spawns refused because the ring was full
+
+	explicit EntityRing(size_t capacity); // Rounded up to a power of two
+
+	size_t capacity() const { return mask + 1; }
+	size_t count() const { return live; }
+	bool full() const { return live == mask + 1; }
+	size_t slot(size_t i) const { return (head + i) & mask; }
+	size_t logical(size_t s) const { return (s - head) & mask; } // Inverse of slot(); >= count() if s isn't live
+
+	size_t pushBack();   // Claim the slot after the newest entity; caller checks full() first
+	void popFront();     // Release the oldest entity
+	void truncate(size_t n); // Keep only the first n entities (after a compaction)
+	void clear();
+	void assign(size_t n);   // Hold n entities in slots [0, n), e.g. after restoring a snapshot; n <= capacity()
+
+	// First logical index whose x is >= value, given x non-decreasing in logical order
+	size_t lowerBound(const std::vector<float>& x, float value) const;
+
+	// Split the live entities into at most two contiguous slot ranges, oldest first.
+	// Returns the number of ranges written to begin/end.
+	int spans(size_t begin[2], size_t end[2]) const;
+	int spansOf(size_t first, size_t last, size_t begin[2], size_t end[2]) const; // Same for logical [first, last)
+
+private:
+	size_t mask;
+	size_t head = 0;
+	size_t live = 0;
+};
+
+
+class ObstacleStore {
+public:
+	EntityRing ring;
+
+	// Hot columns
+	std::vector<float> x, y;
+	std::vector<float> width, height;
+	std::vector<unsigned char> flags;
+
+	// Hitboxes precomputed at spawn (see CollisionKernel.h); y never changes, x offsets scale with width
+	std::vector<float> headReach, headBottom, headTop;
+	std::vector<float> bodyReach, bodyBottom, bodyTop;
+
+	// Cold columns
+	std::vector<float> hitTime;
+
+	float maxWidth = 0.0f; // Widest obstacle spawned, bounds the broadphase window
+
+	explicit ObstacleStore(size_t capacity = DEFAULT_ENTITY_CAPACITY);
+
+	size_t count() const { return ring.count(); }
+	size_t slot(size_t i) const { return ring.slot(i); }
+	void clear();
+	bool spawn(float initX, float initY, float w, float h); // False if the ring is full
+	void overlapRange(float minX, float maxX, size_t& first, size_t& last) const; // Logical [first, last) that can touch [minX, maxX]
+	ObstacleHitboxes hitboxes(size_t beginSlot) const; // Kernel view starting at a column slot
+	void move(float speed); // Scroll every obstacle left
+	void despawnBefore(float minX); // Pop obstacles whose right edge is left of minX
+};
+
+
+class CollectableStore {
+public:
+	EntityRing ring;
+
+	std::vector<float> x, y;
+	std::vector<float> radius;
+	std::vector<unsigned char> flags;
+
+	float maxRadius = 0.0f; // Largest collectable spawned, bounds the broadphase window
+
+	explicit CollectableStore(size_t capacity = DEFAULT_ENTITY_CAPACITY);
+
+	size_t count() const { return ring.count(); }
+	size_t slot(size_t i) const { return ring.slot(i); }
+	void clear();
+	bool spawn(float initX, float initY, float r); // False if the ring is full
+	void overlapRange(float minX, float maxX, size_t& first, size_t& last) const; // Logical [first, last) that can touch [minX, maxX]
+	void move(float speed);
+	void despawnBefore(float minX); // Pop collectables whose right edge is left of minX
+	void removeMarked(); // Drop entities flagged ENTITY_REMOVE, keeping spawn order
+};
+
+
+class PowerUpStore {
+public:
+	EntityRing ring;
+
+	std::vector<float> x, y;
+	std::vector<float> size; // Square side length
+	std::vector<unsigned char> flags;
+
+	float maxSize = 0.0f; // Largest power-up spawned, bounds the broadphase window
+
+	explicit PowerUpStore(size_t capacity = DEFAULT_ENTITY_CAPACITY);
+
+	size_t count() const { return ring.count(); }
+	size_t slot(size_t i) const { return ring.slot(i); }
+	void clear();
+	bool spawn(float initX, float initY, float s, bool speedPowerUp); // False if the ring is full
+	void overlapRange(float minX, float maxX, size_t& first, size_t& last) const; // Logical [first, last) that can touch [minX, maxX]
+	void move(float speed);
+	void despawnBefore(float minX); // Pop power-ups whose right edge is left of minX
+	void removeMarked(); // Drop entities flagged ENTITY_REMOVE, keeping spawn order
+	bool isSpeedPowerUp(size_t i) const { return (flags[slot(i)] & POWERUP_SPEED) != 0; }
+};
@@ -0,0 +1,78 @@
+#if defined(_WIN32)
+#include <windows.h> // wglGetProcAddress
+#endif
+
+#include "GLBuffers.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <GL/glx.h> // glXGetProcAddressARB
+#endif
+
+
+void* lookupGL(const char* name) {
+#if defined(_WIN32)
+	PROC p = wglGetProcAddress(name);
+	intptr_t v = reinterpret_cast<intptr_t>(p);
+	return (v >= -1 && v <= 3) ? nullptr : reinterpret_cast<void*>(p); // Some drivers return small sentinels on failure
+#else
+	return reinterpret_cast<void*>(glXGetProcAddressARB(reinterpret_cast<const GLubyte*>(name)));
+#endif
+}
+
+int glVersion() {
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	if (!version) {
+		return 0;
+	}
+	const char* dot = strchr(version, '.');
+	return atoi(version) * 10 + (dot ? atoi(dot + 1) % 10 : 0);
+}
+
+bool hasGLExtension(const char* name) {
+	const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+	size_t length = strlen(name);
+	for (const char* at = extensions; at && (at = strstr(at, name)) != nullptr; at += length) {
+		if ((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0')) {
+			return true; // Whole names only, so a prefix of a longer name does not match
+		}
+	}
+	return false;
+}
+
+// Core names from GL 1.5, otherwise the ARB_vertex_buffer_object ones; false if neither
+static bool loadBufferApi(BufferApi& api) {
+	const char* suffix = nullptr;
+	if (glVersion() >= 15) {
+		suffix = "";
+	}
+	else if (hasGLExtension("GL_ARB_vertex_buffer_object")) {
+		suffix = "ARB";
+	}
+	if (!suffix) {
+		return false;
+	}
+
+	char name[32];
+	sprintf(name, "glGenBuffers%s", suffix);
+	api.genBuffers = reinterpret_cast<decltype(api.genBuffers)>(lookupGL(name));
+	sprintf(name, "glDeleteBuffers%s", suffix);
+	api.deleteBuffers = reinterpret_cast<decltype(api.deleteBuffers)>(lookupGL(name));
+	sprintf(name, "glBindBuffer%s", suffix);
+	api.bindBuffer = reinterpret_cast<decltype(api.bindBuffer)>(lookupGL(name));
+	sprintf(name, "glBufferData%s", suffix);
+	api.bufferData = reinterpret_cast<decltype(api.bufferData)>(lookupGL(name));
+	return api.genBuffers && api.deleteBuffers && api.bindBuffer && api.bufferData;
+}
+
+const BufferApi* bufferApi() {
+	static BufferApi api;
+	static int state = 0; // 0 not looked up yet, 1 available, -1 unavailable
+	if (state == 0) {
+		state = loadBufferApi(api) ? 1 : -1;
+	}
+	return state > 0 ? &api : nullptr;
+}
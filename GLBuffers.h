@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glut.h>
+
+// Vertex buffer entry points. Buffers are GL 1.5, beyond what opengl32.dll
+// exports on Windows, so they are looked up from the current context: the core
+// names on GL 1.5 and later, otherwise the ARB_vertex_buffer_object ones. GLX
+// hands out addresses even for functions the driver lacks, so lookups are
+// guarded by the version or extension that provides them.
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+struct BufferApi {
+	void (APIENTRY* genBuffers)(GLsizei n, GLuint* buffers);
+	void (APIENTRY* deleteBuffers)(GLsizei n, const GLuint* buffers);
+	void (APIENTRY* bindBuffer)(GLenum target, GLuint buffer);
+	void (APIENTRY* bufferData)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+};
+
+// Looked up on the first call, which needs a current context; nullptr if the
+// context has no vertex buffers. The game has one context, so the result is shared.
+const BufferApi* bufferApi();
+
+// Helpers for looking up other entry points; all need a current context
+void* lookupGL(const char* name);      // nullptr if the driver does not export it
+int glVersion();                       // major * 10 + minor, e.g. 33 for GL 3.3
+bool hasGLExtension(const char* name); // In the GL_EXTENSIONS string
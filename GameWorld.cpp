@@ -0,0 +1,519 @@
+#include "GameWorld.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+Player::Player(float initX, float initY, float w, float h)
+	: x(initX), y(initY), width(w), height(h), jumpHeight(0.0f),
+	isJumping(false), isDucking(false), duckStartTime(0.0f), jumpStartTime(0.0f), invincible(false) {}
+
+void Player::jump(float currentTime) {
+	if (!isJumping) {
+		isJumping = true; // Start jumping
+		jumpStartTime = currentTime; // Record the time the jump starts
+	}
+}
+
+void Player::duck(float currentTime) {
+	if (!isDucking) {
+		isDucking = true; // Start ducking
+		duckStartTime = currentTime; // Record the current time
+		height = 0.05f; // Height when ducking
+	}
+}
+
+// The jump arc is a tween started by GameWorld::jump
+void Player::update(float currentTime) {
+	// Stop ducking after half a second
+	if (isDucking) {
+		if (currentTime - duckStartTime >= 0.5f) {
+			isDucking = false; // Stop ducking
+			width = 0.1f; // Reset width to original
+			height = 0.1f; // Reset height to original
+		}
+	}
+}
+
+
+GameWorld::GameWorld(uint64_t seed, size_t entityCapacity)
+	: player(0.7f, 0.05f, 0.1f, 0.1f),
+	collectables(entityCapacity), powerups(entityCapacity), obstacles(entityCapacity), rng(seed) {
+	contacts.reserve(16);
+	restartSpawns();
+}
+
+void GameWorld::step(float dt) {
+	time += dt;
+	tick++;
+	contacts.clear();
+	stepStartY = player.y;
+	stepStartHeight = player.height;
+	player.update(time); // Update the player state (ducking)
+	updateTweens(); // Jump arc
+	updateGameObjects(dt);  // Update the positions of all objects
+	updateTimer();
+
+	// One collision pass, then the systems that react to it
+	detectContacts();
+	applyDamage();
+	applyScoring();
+	applyPowerUps();
+	removeCollected();
+}
+
+void GameWorld::jump() {
+	if (!player.isJumping) {
+		player.jump(time);
+		// Up over the first 0.75 seconds, back down over the next 0.75
+		tweens.add(TWEEN_PLAYER_Y, 0, 0.05f, 0.05f + player.maxJumpHeight, time, 1.5f, EASE_LINEAR, TWEEN_PINGPONG);
+	}
+}
+
+void GameWorld::duck() {
+	player.duck(time);
+}
+
+void GameWorld::applyInput(unsigned char input) {
+	if (input == INPUT_JUMP) {
+		jump();
+	}
+	else if (input == INPUT_DUCK) {
+		duck();
+	}
+	// Releases don't matter here: ducking ends on its own after half a second
+}
+
+
+// FNV-1a over raw bytes, continuing from hash
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t bytes) {
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < bytes; i++) {
+		hash = (hash ^ p[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+template <typename T>
+static uint64_t fnv1a(uint64_t hash, const T& value) {
+	return fnv1a(hash, &value, sizeof(value));
+}
+
+// Hash one column over the live entities in logical order, so the ring's head
+// position doesn't change the result
+template <typename T>
+static uint64_t hashColumn(uint64_t hash, const EntityRing& ring, const std::vector<T>& column) {
+	size_t begin[2], end[2];
+	int n = ring.spans(begin, end);
+	for (int s = 0; s < n; s++) {
+		hash = fnv1a(hash, column.data() + begin[s], (end[s] - begin[s]) * sizeof(T));
+	}
+	return hash;
+}
+
+uint64_t GameWorld::stateHash() const {
+	uint64_t h = 14695981039346656037ULL; // FNV-1a offset basis
+
+	// Fields one by one: the classes have padding, and padding bytes aren't state
+	h = fnv1a(h, tick); h = fnv1a(h, time);
+	h = fnv1a(h, player.x); h = fnv1a(h, player.y);
+	h = fnv1a(h, player.width); h = fnv1a(h, player.height);
+	h = fnv1a(h, player.isJumping); h = fnv1a(h, player.isDucking); h = fnv1a(h, player.invincible);
+	h = fnv1a(h, player.jumpStartTime); h = fnv1a(h, player.duckStartTime);
+	h = fnv1a(h, gameState); h = fnv1a(h, hearts); h = fnv1a(h, gameTime); h = fnv1a(h, gameScore);
+	h = fnv1a(h, lastUpdateTime);
+	h = fnv1a(h, speed); h = fnv1a(h, originalSpeed); h = fnv1a(h, speedRestoreTime);
+	h = fnv1a(h, lastSpeedIncreaseTime);
+	h = fnv1a(h, speedTimerStart); h = fnv1a(h, invincibilityTimerStart);
+	h = fnv1a(h, spawns.offset); h = fnv1a(h, spawns.lastSpawn); h = fnv1a(h, spawns.nextSeq);
+	h = fnv1a(h, spawns.paused); h = fnv1a(h, spawns.pausedAt);
+	uint32_t tweenCount = static_cast<uint32_t>(tweens.count());
+	h = fnv1a(h, tweenCount);
+	for (size_t i = 0; i < tweens.count(); i++) {
+		h = fnv1a(h, tweens.start[i]); h = fnv1a(h, tweens.from[i]); h = fnv1a(h, tweens.delta[i]);
+		h = fnv1a(h, tweens.kind[i]); h = fnv1a(h, tweens.target[i]);
+	}
+	for (int lane = 0; lane < SPAWN_LANES; lane++) {
+		const PatternChunk& c = patterns.current[lane];
+		h = fnv1a(h, patterns.cursor[lane]); h = fnv1a(h, c.index); h = fnv1a(h, c.next.rngState);
+	}
+	for (const SpawnEvent& e : spawns.events) {
+		h = fnv1a(h, e.key); h = fnv1a(h, e.seq); h = fnv1a(h, e.lane);
+	}
+	h = fnv1a(h, rng.state); h = fnv1a(h, rng.inc);
+
+	uint32_t counts[3] = { static_cast<uint32_t>(obstacles.count()), static_cast<uint32_t>(collectables.count()),
+		static_cast<uint32_t>(powerups.count()) }; // Fixed width so 32- and 64-bit builds agree
+	h = fnv1a(h, counts);
+	h = hashColumn(h, obstacles.ring, obstacles.x); h = hashColumn(h, obstacles.ring, obstacles.y);
+	h = hashColumn(h, obstacles.ring, obstacles.width); h = hashColumn(h, obstacles.ring, obstacles.height);
+	h = hashColumn(h, obstacles.ring, obstacles.flags); h = hashColumn(h, obstacles.ring, obstacles.hitTime);
+	h = hashColumn(h, collectables.ring, collectables.x); h = hashColumn(h, collectables.ring, collectables.y);
+	h = hashColumn(h, collectables.ring, collectables.radius);
+	h = hashColumn(h, powerups.ring, powerups.x); h = hashColumn(h, powerups.ring, powerups.y);
+	h = hashColumn(h, powerups.ring, powerups.size); h = hashColumn(h, powerups.ring, powerups.flags);
+	return h;
+}
+
+// Spawning logic; layouts come pre-generated from the pattern chunks
+void GameWorld::spawnCollectable() {
+	PatternItem c = patterns.next(LANE_COLLECTABLE);
+	collectables.spawn(3.0f, c.y, c.width);  // Add new collectable to the store
+}
+
+void GameWorld::spawnPowerUp() {
+	PatternItem p = patterns.next(LANE_POWERUP);
+	powerups.spawn(3.0f, p.y, p.width, (p.flags & POWERUP_SPEED) != 0);  // Add new power-up to the store
+}
+
+void GameWorld::spawnObstacle() {
+	PatternItem o = patterns.next(LANE_OBSTACLE); // Validated so the player can get past it
+	obstacles.spawn(3.0f, o.y, o.width, o.height);  // Add new obstacle to the store
+}
+
+void GameWorld::restartSpawns() {
+	patterns.rules.obstacleInterval = spawnObstacleTime;
+	patterns.rules.scrollSpeed = originalSpeed / SIM_STEP;
+	patterns.restart(rng);
+
+	spawns.clear();
+	spawns.schedule(LANE_OBSTACLE, time + spawnObstacleTime);
+	spawns.schedule(LANE_COLLECTABLE, time + spawnCollectableTime);
+	spawns.schedule(LANE_POWERUP, time + spawnPowerUpTime);
+}
+
+void GameWorld::updateSpawns() {
+	int lane;
+	while (spawns.popDue(time, lane)) {
+		if (lane == LANE_OBSTACLE) {
+			spawnObstacle();
+			spawns.schedule(LANE_OBSTACLE, time + spawnObstacleTime);
+		}
+		else if (lane == LANE_COLLECTABLE) {
+			spawnCollectable();
+			spawns.schedule(LANE_COLLECTABLE, time + spawnCollectableTime);
+		}
+		else {
+			spawnPowerUp();
+			spawns.schedule(LANE_POWERUP, time + spawnPowerUpTime);
+		}
+	}
+}
+
+
+// Player x interval for the broadphase, padded so float rounding never prunes a touching entity
+float GameWorld::playerMinX(float px) const {
+	return px - BROADPHASE_MARGIN;
+}
+
+float GameWorld::playerMaxX(float px) const {
+	return px + player.width + BROADPHASE_MARGIN;
+}
+
+
+void GameWorld::detectContacts() {
+	// Obstacles first: a hit moves the player, and pickups are tested where it ends up
+	float px = detectObstacleContacts(player.x);
+	detectPickupContacts(px);
+}
+
+
+// Player box at the start and end of the step when it stands at px; only jumping and
+// ducking move it within a step, push-backs are applied as instant jumps in x
+static void playerSweep(const GameWorld& w, float px, PlayerBox& start, PlayerBox& end) {
+	start = { px, px + w.player.width, w.stepStartY, w.stepStartY + w.stepStartHeight, w.stepTravel };
+	end = { px, px + w.player.width, w.player.y, w.player.y + w.player.height, w.stepTravel };
+}
+
+
+// Run the batched hitbox kernel over the obstacles near the player and record the hits
+// in order. A hit pushes the player back, so the rest of the window is re-tested
+// against the new player box, exactly like a sequential scan would. The kernel
+// tests the area swept over the step; sweptBoxHit confirms each candidate.
+float GameWorld::detectObstacleContacts(float px) {
+	if (player.invincible || hearts == 0 || gameState == 2) {
+		return px; // No collision if invincible or the game is already decided
+	}
+
+	int heartsLeft = hearts; // Each hit costs a heart; stop once they would run out
+	size_t first, last;
+	obstacles.overlapRange(playerMinX(px) - stepTravel, playerMaxX(px), first, last);
+
+	size_t next = first;
+	while (next < last && heartsLeft > 0) {
+		PlayerBox start, end;
+		playerSweep(*this, px, start, end);
+		PlayerBox box = { px, px + player.width, std::min(start.bottom, end.bottom), std::max(start.top, end.top), stepTravel };
+		size_t begin[2], ends[2];
+		int spans = obstacles.ring.spansOf(next, last, begin, ends);
+		size_t logical = next;
+		bool moved = false;
+
+		for (int sp = 0; sp < spans && !moved; sp++) {
+			size_t n = ends[sp] - begin[sp];
+			hitBits.resize((n + 31) / 32);
+			testObstacleHitboxes(obstacles.hitboxes(begin[sp]), n, box, hitBits.data());
+
+			for (size_t k = 0; k < n; k++) {
+				if (hitBits[k >> 5] == 0) {
+					k |= 31; // Skip the rest of an empty word
+					continue;
+				}
+				size_t s = begin[sp] + k;
+				if (!(hitBits[k >> 5] & (1u << (k & 31))) || (obstacles.flags[s] & OBSTACLE_HIT_PLAYER)) {
+					continue; // Missed, or the obstacle recently hit the player
+				}
+
+				// Screw head and body
+				float ox = obstacles.x[s];
+				float headToi, bodyToi;
+				bool head = sweptBoxHit(start, end, ox, ox + obstacles.headReach[s],
+					obstacles.headBottom[s], obstacles.headTop[s], stepTravel, headToi);
+				bool body = sweptBoxHit(start, end, ox - obstacles.bodyReach[s], ox,
+					obstacles.bodyBottom[s], obstacles.bodyTop[s], stepTravel, bodyToi);
+				if (!head && !body) {
+					continue;
+				}
+
+				// Push the player back to the start of the obstacle's body
+				px = (ox - obstacles.bodyReach[s]) - 0.1f;
+
+				float toi = (head && body) ? std::min(headToi, bodyToi) : (head ? headToi : bodyToi);
+				Contact c = { CONTACT_OBSTACLE, logical + k, px, toi, ox - obstacles.bodyReach[s], player.y + player.height * 0.5f };
+				contacts.push_back(c);
+				heartsLeft--;
+				next = logical + k + 1;
+				moved = true;
+				break;
+			}
+			logical += n;
+		}
+		if (!moved) {
+			break;
+		}
+	}
+	return px;
+}
+
+
+void GameWorld::detectPickupContacts(float px) {
+	size_t first, last;
+	PlayerBox start, end;
+	playerSweep(*this, px, start, end);
+
+	// Treat the collectable as a circular area around the player's center
+	float cx = px + player.width * 0.5f;
+	float startY = stepStartY + stepStartHeight * 0.5f;
+	float endY = player.y + player.height * 0.5f;
+	collectables.overlapRange(playerMinX(px) - stepTravel, playerMaxX(px), first, last);
+	for (size_t i = first; i < last; i++) {
+		size_t s = collectables.slot(i);
+		float toi;
+		if (sweptCircleHit(cx, startY, cx, endY, player.width * 0.5f + collectables.radius[s],
+			collectables.x[s], collectables.y[s], stepTravel, toi)) {
+			Contact c = { CONTACT_COLLECTABLE, i, 0.0f, toi, collectables.x[s], collectables.y[s] };
+			contacts.push_back(c);
+		}
+	}
+
+	// Power-ups collide as the square [x, x + size]
+	powerups.overlapRange(playerMinX(px) - stepTravel, playerMaxX(px), first, last);
+	for (size_t i = first; i < last; i++) {
+		size_t s = powerups.slot(i);
+		float toi;
+		if (sweptBoxHit(start, end, powerups.x[s], powerups.x[s] + powerups.size[s],
+			powerups.y[s], powerups.y[s] + powerups.size[s], stepTravel, toi)) {
+			float half = powerups.size[s] * 0.5f;
+			Contact c = { powerups.isSpeedPowerUp(i) ? CONTACT_SPEED_POWERUP : CONTACT_INVINCIBILITY_POWERUP, i, 0.0f, toi,
+				powerups.x[s] + half, powerups.y[s] + half };
+			contacts.push_back(c);
+		}
+	}
+}
+
+
+void GameWorld::applyDamage() {
+	for (const Contact& c : contacts) {
+		if (c.type != CONTACT_OBSTACLE) {
+			continue;
+		}
+		hearts--; // Reduce hearts
+
+		// Mark the obstacle as recently hit and store the timestamp
+		size_t s = obstacles.slot(c.index);
+		obstacles.flags[s] |= OBSTACLE_HIT_PLAYER;
+		obstacles.hitTime[s] = time;
+		scheduleTimer(TIMER_OBSTACLE_HIT, time + 0.5f, time, static_cast<uint32_t>(s)); // Can hit again after 0.5 seconds
+
+		speed = 0.0f;
+		speedRestoreTime = time + 1.0f;  // Set the time to restore speed
+		scheduleTimer(TIMER_SPEED_RESTORE, speedRestoreTime, speedRestoreTime);
+
+		spawns.shift(1.0f); // Hold back upcoming spawns while the world stalls
+
+		player.x = c.pushBackX;
+	}
+}
+
+void GameWorld::applyScoring() {
+	for (const Contact& c : contacts) {
+		if (c.type == CONTACT_COLLECTABLE) {
+			gameScore += 10000; // Increase score
+		}
+	}
+}
+
+void GameWorld::applyPowerUps() {
+	for (const Contact& c : contacts) {
+		if (c.type == CONTACT_SPEED_POWERUP) {
+			speed *= 0.5f; // Cut speed by half
+			speedTimerStart = time; // Set timer for 15 seconds
+		}
+		else if (c.type == CONTACT_INVINCIBILITY_POWERUP) {
+			player.invincible = true; // Set invincible flag
+			invincibilityTimerStart = time; // Start the timer
+			scheduleTimer(TIMER_INVINCIBILITY, time + 10.0f, time);
+		}
+	}
+}
+
+void GameWorld::removeCollected() {
+	bool anyCollectable = false;
+	bool anyPowerUp = false;
+	for (const Contact& c : contacts) {
+		if (c.type == CONTACT_COLLECTABLE) {
+			collectables.flags[collectables.slot(c.index)] |= ENTITY_REMOVE;
+			anyCollectable = true;
+		}
+		else if (c.type == CONTACT_SPEED_POWERUP || c.type == CONTACT_INVINCIBILITY_POWERUP) {
+			powerups.flags[powerups.slot(c.index)] |= ENTITY_REMOVE;
+			anyPowerUp = true;
+		}
+	}
+	if (anyCollectable) {
+		collectables.removeMarked();
+	}
+	if (anyPowerUp) {
+		powerups.removeMarked();
+	}
+}
+
+
+void GameWorld::updateTimer() {
+	// Check if 1 second has passed since the last update
+	if (time - lastUpdateTime >= 1.0f) {
+		if (gameTime > 0) {
+			gameTime--;  // Decrement the game time by 1 second
+		}
+
+		// Check if it's time to increase the speed
+		if (gameTime % speedIncreaseInterval == 0 && gameTime != lastSpeedIncreaseTime) {
+			speed += speedIncrement;  // Increase the speed
+			originalSpeed += speedIncrement;
+			lastSpeedIncreaseTime = gameTime;  // Update the last time speed was increased
+		}
+
+		lastUpdateTime = time;  // Reset the last update time to the current time
+	}
+
+	if (hearts <= 0) {
+		gameState = 1;  // You Lose
+	}
+
+	// Check if player wins (time is 0)
+	if (gameTime == 0) {
+		gameState = 2;  // You Win
+	}
+}
+
+
+// Timed effects, scheduled by whatever starts them
+void GameWorld::scheduleTimer(uint8_t kind, float dueTime, float stamp, uint32_t target) {
+	// One bucket early: the handler re-checks the exact condition, and a bucket rounded
+	// from dueTime could otherwise land a step after the old per-tick poll would have fired
+	uint64_t due = timerBucket(dueTime);
+	Timer t = { due > 0 ? due - 1 : 0, stamp, target, kind };
+	timers.schedule(t);
+}
+
+void GameWorld::runTimers() {
+	timers.advance(timerBucket(time), [this](const Timer& t) { return fireTimer(t); });
+}
+
+bool GameWorld::fireTimer(const Timer& t) {
+	switch (t.kind) {
+	case TIMER_OBSTACLE_HIT: {
+		// Stale if the obstacle despawned or its slot now holds another one; logical()
+		// wraps, so it only bounds slots inside the ring
+		size_t s = t.target;
+		if (s >= obstacles.ring.capacity() || obstacles.ring.logical(s) >= obstacles.count() ||
+			!(obstacles.flags[s] & OBSTACLE_HIT_PLAYER) ||
+			obstacles.hitTime[s] != t.stamp) {
+			return true;
+		}
+		if (time - obstacles.hitTime[s] < 0.5f) {
+			return false;
+		}
+		obstacles.flags[s] &= ~OBSTACLE_HIT_PLAYER; // Reset after 0.5 seconds
+		return true;
+	}
+	case TIMER_SPEED_RESTORE:
+		// Stale if a later hit moved the restore time, or something else already got us moving
+		if (t.stamp != speedRestoreTime || speed != 0.0f) {
+			return true;
+		}
+		if (time < speedRestoreTime) {
+			return false;
+		}
+		speed = originalSpeed;  // Restore the speed
+		return true;
+	case TIMER_INVINCIBILITY:
+		if (!player.invincible || t.stamp != invincibilityTimerStart) {
+			return true; // A later power-up restarted the clock
+		}
+		if (time - invincibilityTimerStart < 10.0f) { // Check if 10 seconds have passed
+			return false;
+		}
+		player.invincible = false;  // Remove invincibility
+		return true;
+	default:
+		return true;
+	}
+}
+
+
+// Evaluate every tween in one pass, then write the values to what they drive
+void GameWorld::updateTweens() {
+	tweens.evaluate(time);
+	for (size_t i = 0; i < tweens.count(); i++) {
+		float v = tweens.value[i];
+		bool finished = tweens.done[i] != 0;
+		if (tweens.kind[i] == TWEEN_PLAYER_Y) {
+			player.y = v; // Back at ground level when finished
+			if (finished) {
+				player.isJumping = false;
+			}
+		}
+	}
+	tweens.retireDone();
+}
+
+
+void GameWorld::updateGameObjects(float dt) {
+	runTimers(); // Speed restore, hit flag resets and invincibility expiry
+
+	stepTravel = speed * (dt / SIM_STEP); // speed is per reference step
+	obstacles.move(stepTravel); // Regular movement
+
+	// Move all power-ups and collectables
+	powerups.move(stepTravel);
+	collectables.move(stepTravel);
+
+	// Retire everything that has scrolled off the left edge and is behind the player
+	float despawnX = std::min(0.0f, player.x);
+	obstacles.despawnBefore(despawnX);
+	collectables.despawnBefore(despawnX);
+	powerups.despawnBefore(despawnX);
+
+	updateSpawns(); // Spawn whatever has come due
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "EntityStore.h"
+#include "PatternGenerator.h"
+#include "Random.h"
+#include "Replay.h"
+#include "SpawnScheduler.h"
+#include "TimerWheel.h"
+#include "Tween.h"
+
+// Reference simulation step. Per-step constants such as speed were tuned at 16 ms;
+// step(dt) scales them by dt / SIM_STEP, and the swept collision tests keep
+// larger steps from tunnelling through thin obstacles.
+const float SIM_STEP = 0.016f;
+
+// Padding on the broadphase query interval
+const float BROADPHASE_MARGIN = 1e-4f;
+
+
+// Timer kinds in GameWorld::timers
+const uint8_t TIMER_OBSTACLE_HIT = 0;    // target: obstacle slot, stamp: its hitTime; clears OBSTACLE_HIT_PLAYER
+const uint8_t TIMER_SPEED_RESTORE = 1;   // stamp: speedRestoreTime; ends the stall after a hit
+const uint8_t TIMER_INVINCIBILITY = 2;   // stamp: invincibilityTimerStart; ends the power-up
+
+
+// Tween kinds in GameWorld::tweens
+const uint16_t TWEEN_PLAYER_Y = 0; // The jump arc
+
+
+// What the player touched this tick
+enum ContactType : unsigned char {
+	CONTACT_OBSTACLE,              // Costs a heart and pushes the player back
+	CONTACT_COLLECTABLE,
+	CONTACT_SPEED_POWERUP,
+	CONTACT_INVINCIBILITY_POWERUP
+};
+
+// Written by the collision pass, read by the systems that run after it
+struct Contact {
+	ContactType type;
+	size_t index;    // Logical index into the matching store, valid until the removal system runs
+	float pushBackX; // Obstacles only: player x after the hit
+	float toi;       // Time of impact as a fraction of the step, 0 = already touching at its start
+	float x, y;      // Where it happened, for effects: the struck face of an obstacle, the center of a pickup
+};
+
+
+class Player {
+public:
+	float x, y; // Player position
+	float width, height; // Player size
+	float jumpHeight; // Height for jump
+	bool isJumping; // Flag for jump state
+	bool isDucking; // Flag for duck state
+	float duckStartTime; // Simulated time (seconds) when ducking started
+	float jumpStartTime; // Simulated time (seconds) when jumping started
+	float maxJumpHeight = 0.3f; // Maximum height during the jump
+	bool invincible; // New attribute for invincibility
+
+	Player(float initX, float initY, float w, float h);
+	void draw(); // Render the player
+	void jump(float currentTime); // Handle jumping
+	void duck(float currentTime); // Handle ducking
+	void update(float currentTime); // Update player state; the jump arc runs as a tween
+};
+
+
+// All gameplay state and rules, steppable without a window or GL context.
+// The GLUT front-end owns one of these and only reads it for drawing.
+class GameWorld {
+public:
+	Player player;
+	CollectableStore collectables;
+	PowerUpStore powerups;
+	ObstacleStore obstacles;
+	Random rng; // Seeds the spawn patterns; seed it (then restartSpawns()) to reproduce a run
+
+	float time = 0.0f; // Simulated seconds since the world started
+	uint32_t tick = 0; // Steps completed; replays tag inputs with it
+	float stepTravel = 0.0f; // Distance everything scrolled in the current step
+	float stepStartY = 0.05f, stepStartHeight = 0.1f; // Player's vertical extent before the current step
+	int gameState = 0; // 0 playing, 1 lost, 2 won
+	int hearts = 5;
+	int gameTime = 90; // Seconds left on the game clock
+	int gameScore = 0;
+	float lastUpdateTime = 0.0f; // Last time the game clock ticked down
+
+	float speed = 0.01f; // Scroll distance per simulation step
+	float originalSpeed = 0.01f;  // Speed to restore after a hit
+	float speedRestoreTime = 0.0f; // Track when to restore the speed
+	int speedIncreaseInterval = 30; // Speed increases every 30 seconds
+	float speedIncrement = 0.005f;  // How much it increases by
+	int lastSpeedIncreaseTime = 0; // Game clock value when the speed was last increased
+
+	float speedTimerStart = 0.0f;         // Store the time when the speed power-up starts
+	float invincibilityTimerStart = 0.0f; // Store the time when the invincibility power-up starts
+
+	float spawnCollectableTime = 11.0f; // Collectables every 10 seconds
+	float spawnPowerUpTime = 13.0f;     // Power-ups every 15 seconds
+	float spawnObstacleTime = 3.0f;     // Obstacles every 5 seconds
+
+	PatternSource patterns; // Layout of every spawn, generated ahead in validated chunks
+	SpawnScheduler spawns; // Upcoming spawns; each lane reschedules itself one interval after it spawns
+
+	TweenSystem tweens; // Running animations of sim state
+	TimerWheel timers; // Expiry of hit flags, the speed stall and invincibility
+	std::vector<Contact> contacts; // This tick's contacts in detection order; the front-end reads them for audio
+	std::vector<uint32_t> hitBits; // Scratch output of the obstacle hitbox kernel
+
+	explicit GameWorld(uint64_t seed = 1, size_t entityCapacity = DEFAULT_ENTITY_CAPACITY); // Ring capacity per entity type
+	void step(float dt = SIM_STEP); // Advance the simulation by dt seconds
+	void jump(); // Player input, applied at the current simulated time
+	void duck();
+	void applyInput(unsigned char input); // An INPUT_* byte from a live key press or a replay
+
+	uint64_t stateHash() const; // FNV-1a over everything that affects future steps
+
+	void spawnCollectable();
+	void spawnPowerUp();
+	void spawnObstacle();
+	void restartSpawns(); // New patterns from rng, first spawn of every lane one interval from now; after reseeding or retuning
+	void updateSpawns();
+	void updateTimer();
+	void updateGameObjects(float dt);
+	void updateTweens();
+	void scheduleTimer(uint8_t kind, float dueTime, float stamp, uint32_t target = 0);
+	void runTimers(); // Fire everything due by the current time
+	bool fireTimer(const Timer& timer); // False if it isn't quite due yet
+
+	// Player x interval for the broadphase when the player stands at px
+	float playerMinX(float px) const;
+	float playerMaxX(float px) const;
+
+	// Collision pass: tests every store once, swept over the step, and only appends to contacts
+	void detectContacts();
+	float detectObstacleContacts(float px); // Returns the player x after any push-backs
+	void detectPickupContacts(float px);
+
+	// Systems consuming the contacts, in this order
+	void applyDamage();     // Hearts, push-back and the speed stall
+	void applyScoring();
+	void applyPowerUps();
+	void removeCollected(); // Drop picked-up collectables and power-ups; invalidates contact indices
+};
+
@@ -0,0 +1,133 @@
+#include "GlyphAtlas.h"
+
+#include <algorithm>
+#include <cstdio>
+
+
+void GlyphAtlas::build(void* glutFont) {
+	// One cell per glyph, its origin far enough in for GLUT's widest glyphs and deepest descenders
+	const int cell = 64, originX = 16, originY = 16;
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (viewport[2] < cell || viewport[3] < cell) {
+		return; // Not even one cell fits; still unbuilt, so the caller tries again on a later frame
+	}
+	int columns = viewport[2] / cell, rows = viewport[3] / cell;
+	int width = columns * cell, height = rows * cell; // Whole cells only, so the read stays inside the viewport
+
+	glPushAttrib(GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_ENABLE_BIT | GL_TRANSFORM_BIT);
+	glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+	glDisable(GL_BLEND);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0.0, viewport[2], 0.0, viewport[3], -1.0, 1.0); // One unit per pixel
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	rects.clear();
+	std::vector<unsigned char> pixels(static_cast<size_t>(width) * height);
+	std::vector<float> open, grown; // Rectangles reaching the previous row, and those reaching this one
+	for (int start = 0; start < GLYPH_COUNT; start += columns * rows) {
+		int batchCount = std::min(columns * rows, GLYPH_COUNT - start);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glColor3f(1.0f, 1.0f, 1.0f);
+		for (int k = 0; k < batchCount; k++) {
+			glRasterPos2i((k % columns) * cell + originX, (k / columns) * cell + originY);
+			glutBitmapCharacter(glutFont, GLYPH_FIRST + start + k);
+		}
+		glReadPixels(viewport[0], viewport[1], width, height, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+
+		for (int k = 0; k < batchCount; k++) {
+			int left = (k % columns) * cell, bottom = (k / columns) * cell;
+			Glyph& g = glyphs[start + k];
+			g.first = static_cast<uint32_t>(rects.size() / 4);
+			g.advance = static_cast<float>(glutBitmapWidth(glutFont, GLYPH_FIRST + start + k));
+			open.clear();
+			for (int y = 0; y <= cell; y++) {
+				// Runs of lit pixels in this row; the row past the cell has none, which closes everything
+				grown.clear();
+				const unsigned char* row = pixels.data() + static_cast<size_t>(bottom + std::min(y, cell - 1)) * width + left;
+				for (int x = 0; y < cell && x < cell; x++) {
+					if (row[x] < 128) {
+						continue;
+					}
+					int end = x;
+					while (end < cell && row[end] >= 128) {
+						end++;
+					}
+					float rect[4] = { float(x - originX), float(y - originY), float(end - originX), float(y + 1 - originY) };
+					for (size_t r = 0; r < open.size(); r += 4) {
+						if (open[r] == rect[0] && open[r + 2] == rect[2]) {
+							rect[1] = open[r + 1]; // The same run as the row below: grow that rectangle
+							std::copy(open.end() - 4, open.end(), open.begin() + r);
+							open.resize(open.size() - 4);
+							break;
+						}
+					}
+					grown.insert(grown.end(), rect, rect + 4);
+					x = end;
+				}
+				rects.insert(rects.end(), open.begin(), open.end()); // Whatever did not continue is finished
+				open.swap(grown);
+			}
+			g.count = static_cast<uint32_t>(rects.size() / 4) - g.first;
+		}
+	}
+
+	glClear(GL_COLOR_BUFFER_BIT);
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glPopClientAttrib();
+	glPopAttrib(); // Also restores the matrix mode the caller had
+	font = glutFont;
+}
+
+
+void TextMesh::set(const GlyphAtlas& atlas, const char* s) {
+	if (laidOutWith == &atlas && text == s) {
+		return;
+	}
+	if (!atlas.built()) {
+		rects.clear(); // Nothing to draw yet; laid out for real once the atlas exists
+		laidOutWith = nullptr;
+		return;
+	}
+	text = s;
+	laidOutWith = &atlas;
+	layouts++;
+	rects.clear();
+	float pen = 0.0f;
+	for (const char* c = s; *c != '\0'; ++c) {
+		int index = static_cast<unsigned char>(*c) - GLYPH_FIRST;
+		if (index < 0 || index >= GLYPH_COUNT) {
+			continue;
+		}
+		const GlyphAtlas::Glyph& g = atlas.glyphs[index];
+		for (uint32_t r = g.first; r < g.first + g.count; r++) {
+			const float* q = &atlas.rects[4 * r];
+			const float placed[4] = { q[0] + pen, q[1], q[2] + pen, q[3] };
+			rects.insert(rects.end(), placed, placed + 4);
+		}
+		pen += g.advance;
+	}
+}
+
+void TextMesh::setNumber(const GlyphAtlas& atlas, const char* format, int value) {
+	if (laidOutWith == &atlas && numberFormat == format && numberValue == value) {
+		return;
+	}
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), format, value);
+	numberFormat = format;
+	numberValue = value;
+	set(atlas, buffer);
+}
+
+void TextMesh::draw(BatchRenderer& batch, float x, float y) const {
+	batch.appendPixelRects(rects, x, y);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BatchRenderer.h"
+
+// Bitmap text as batch geometry. GLUT draws its fonts with one glBitmap per
+// character, so build() draws every printable glyph once into the back buffer,
+// reads the pixels back and keeps each glyph as the rectangles covering its set
+// pixels: one per horizontal run, extended down the rows while the run repeats.
+// A TextMesh lays a string out from those once, then only replays its
+// rectangles into the batch, so text joins the frame's single draw and costs
+// no more work until the string changes.
+//
+// Rectangles are in pixels from the raster position, so the text matches
+// glutBitmapCharacter pixel for pixel at any viewport size.
+
+const int GLYPH_FIRST = 32; // Space
+const int GLYPH_COUNT = 95; // Space through '~'
+
+class GlyphAtlas {
+public:
+	struct Glyph {
+		uint32_t first, count; // Range of rectangles in rects
+		float advance;         // Pixels to the next glyph's origin
+	};
+
+	Glyph glyphs[GLYPH_COUNT] = {};
+	std::vector<float> rects; // x0, y0, x1, y1 per rectangle, in pixels from the glyph's origin
+	void* font = nullptr;     // GLUT bitmap font it was read from; nullptr until built
+
+	bool built() const { return font != nullptr; }
+
+	// Draws into the color buffer and clears it again, so call it before the frame's own drawing.
+	// Does nothing while the viewport is smaller than a 64 px glyph cell.
+	void build(void* glutFont);
+};
+
+class TextMesh {
+public:
+	std::string text;         // What rects spells
+	std::vector<float> rects; // Laid out, in pixels from the string's raster position
+	uint32_t layouts = 0;     // Times laid out; stays put while the text does
+
+	void set(const GlyphAtlas& atlas, const char* s); // Lays out again only if s differs from text; empty until atlas is built
+
+	// sprintf(format, value), but only when the value or format has changed
+	void setNumber(const GlyphAtlas& atlas, const char* format, int value);
+
+	// At raster position x, y (world units), in the batch's current color
+	void draw(BatchRenderer& batch, float x, float y) const;
+
+private:
+	const GlyphAtlas* laidOutWith = nullptr;
+	const char* numberFormat = nullptr;
+	int numberValue = 0;
+};
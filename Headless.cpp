@@ -0,0 +1,251 @@
+// Headless driver: steps a GameWorld as fast as the CPU allows, no window or GL context.
+// Usage: HeadlessSim [maxTicks] [seed] [dt]
+//        HeadlessSim --replay <file> [--trace <out>]   (trace: one "tick hash" line per step)
+//        HeadlessSim --batch <runs> [--threads n] [--seed n] [--out file] [--dt s] [--max-ticks n]
+//                    [--obstacle-every s] [--collectable-every s] [--powerup-every s] [--spawn-gap s]
+//                    [--start-speed f] [--speed-every s] [--speed-step f] [--autoplay lookahead s]
+//        HeadlessSim --autoplay [maxTicks] [seed] [replay out]   (lookahead bot plays; its inputs can be saved as a replay)
+//        HeadlessSim --particles [live] [frames]   (particle update benchmark, default 100000 live for 3600 frames)
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#include "Autoplay.h"
+#include "BatchRunner.h"
+#include "GameWorld.h"
+#include "ParticlePool.h"
+
+
+static void printSummary(const GameWorld& world, long ticks, float dt, double seconds) {
+	const char* result = (world.gameState == 1) ? "lost" : (world.gameState == 2) ? "won" : "running";
+	printf("result: %s\n", result);
+	printf("ticks: %ld of %.3f s (%.1f simulated s)\n", ticks, dt, world.time);
+	printf("score: %d, hearts: %d, time left: %d\n", world.gameScore, world.hearts, world.gameTime);
+	printf("obstacles: %zu live, %zu peak, %llu despawned, %llu dropped\n", world.obstacles.count(),
+		world.obstacles.ring.peak, world.obstacles.ring.despawned, world.obstacles.ring.dropped);
+	printf("collectables: %zu live, %zu peak; power-ups: %zu live, %zu peak\n", world.collectables.count(),
+		world.collectables.ring.peak, world.powerups.count(), world.powerups.ring.peak);
+	printf("collision kernel: %s\n", collisionKernelName(activeCollisionKernel()));
+	printf("wall: %.3f ms (%.0f ticks/s)\n", seconds * 1000.0, seconds > 0.0 ? ticks / seconds : 0.0);
+}
+
+// Ticks a replay without a tick count may run, the same as the other modes' default
+static const uint32_t UNTIMED_REPLAY_TICKS = 100000;
+
+// Re-run a recorded game and check its state hashes; returns the process exit code
+static int runReplay(const char* path, const char* tracePath) {
+	Replay replay;
+	if (!replay.load(path)) {
+		fprintf(stderr, "can't read replay %s\n", path);
+		return 2;
+	}
+	FILE* trace = nullptr;
+	if (tracePath && !(trace = fopen(tracePath, "w"))) {
+		fprintf(stderr, "can't write trace %s\n", tracePath);
+		return 2;
+	}
+
+	GameWorld world(replay.seed);
+	uint64_t runningHash = 0;
+	size_t nextEvent = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	// A replay without a tick count (cut short) runs until the game ends, or the tick limit
+	while (replay.ticks > 0 ? world.tick < replay.ticks : (world.gameState == 0 && world.tick < UNTIMED_REPLAY_TICKS)) {
+		while (nextEvent < replay.events.size() && replay.events[nextEvent].tick <= world.tick) {
+			world.applyInput(replay.events[nextEvent++].input);
+		}
+		world.step(replay.dt);
+
+		uint64_t hash = world.stateHash();
+		runningHash = foldStateHash(runningHash, hash);
+		if (trace) {
+			fprintf(trace, "%u %016llx\n", world.tick, static_cast<unsigned long long>(hash));
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	if (trace) {
+		fclose(trace);
+	}
+
+	printSummary(world, world.tick, replay.dt, std::chrono::duration<double>(end - start).count());
+	printf("replay: %zu inputs, hash %016llx", replay.events.size(), static_cast<unsigned long long>(runningHash));
+	if (replay.finalHash == 0) {
+		printf(" (none recorded)\n");
+		return 0;
+	}
+	bool match = runningHash == replay.finalHash;
+	printf(match ? " (matches)\n" : " (MISMATCH, recorded %016llx)\n", static_cast<unsigned long long>(replay.finalHash));
+	return match ? 0 : 1;
+}
+
+
+// Simulate a batch of worlds across cores; returns the process exit code
+static int runBatch(int argc, char** argv) {
+	uint32_t runs = static_cast<uint32_t>(strtoul(argv[2], nullptr, 10));
+	unsigned threads = 0;
+	const char* outPath = nullptr;
+	BatchRunner batch;
+	BatchConfig& c = batch.config;
+
+	for (int i = 3; i + 1 < argc; i += 2) {
+		const char* flag = argv[i];
+		const char* value = argv[i + 1];
+		if (strcmp(flag, "--threads") == 0) threads = static_cast<unsigned>(atoi(value));
+		else if (strcmp(flag, "--seed") == 0) c.seed = strtoull(value, nullptr, 10);
+		else if (strcmp(flag, "--out") == 0) outPath = value;
+		else if (strcmp(flag, "--dt") == 0) c.dt = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--max-ticks") == 0) c.maxTicks = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+		else if (strcmp(flag, "--obstacle-every") == 0) c.spawnObstacleTime = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--collectable-every") == 0) c.spawnCollectableTime = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--powerup-every") == 0) c.spawnPowerUpTime = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--spawn-gap") == 0) c.spawnSeparation = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--start-speed") == 0) c.startSpeed = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--speed-every") == 0) c.speedIncreaseInterval = atoi(value);
+		else if (strcmp(flag, "--speed-step") == 0) c.speedIncrement = static_cast<float>(atof(value));
+		else if (strcmp(flag, "--autoplay") == 0) c.autoplayLookahead = static_cast<float>(atof(value));
+		else {
+			fprintf(stderr, "unknown batch option %s\n", flag);
+			return 2;
+		}
+	}
+	if (c.dt <= 0.0f) {
+		c.dt = SIM_STEP;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	batch.run(runs, threads);
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	// Aggregate for a quick look; the column file has every run
+	unsigned long long outcomes[3] = { 0, 0, 0 }, causes[4] = { 0, 0, 0, 0 };
+	double scoreSum = 0.0, tickSum = 0.0;
+	for (const RunSummary& r : batch.results) {
+		outcomes[r.outcome]++;
+		causes[r.cause]++;
+		scoreSum += r.score;
+		tickSum += r.ticks;
+	}
+	double n = runs > 0 ? runs : 1;
+	printf("runs: %u (won %llu, lost %llu, timed out %llu)\n", runs, outcomes[RUN_WON], outcomes[RUN_LOST], outcomes[RUN_TIMEOUT]);
+	printf("deaths while running %llu, jumping %llu, ducking %llu\n", causes[CAUSE_RUNNING], causes[CAUSE_JUMPING], causes[CAUSE_DUCKING]);
+	printf("mean score: %.1f, mean ticks: %.1f\n", scoreSum / n, tickSum / n);
+	printf("wall: %.3f ms (%.0f runs/s, %.0f ticks/s)\n", seconds * 1000.0,
+		seconds > 0.0 ? runs / seconds : 0.0, seconds > 0.0 ? tickSum / seconds : 0.0);
+
+	if (outPath && !batch.writeColumns(outPath)) {
+		fprintf(stderr, "can't write %s\n", outPath);
+		return 2;
+	}
+	return 0;
+}
+
+// One game played by the lookahead bot, e.g. as a reproducible soak load;
+// returns the process exit code
+static int runAutoplay(long maxTicks, uint64_t seed, const char* replayPath) {
+	GameWorld world(seed);
+	Autoplayer bot;
+	Replay replay;
+	replay.seed = seed;
+	replay.dt = SIM_STEP;
+	uint64_t runningHash = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	while (world.tick < maxTicks && world.gameState == 0) {
+		unsigned char press = bot.poll(world);
+		if (press != AUTOPLAY_WAIT) {
+			replay.record(world.tick, press);
+			world.applyInput(press);
+		}
+		world.step();
+		runningHash = foldStateHash(runningHash, world.stateHash());
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	printSummary(world, world.tick, SIM_STEP, seconds);
+	printf("autoplay: %llu decisions (%.0f/s), %llu inputs, %llu plans, %llu simulated ticks\n",
+		static_cast<unsigned long long>(bot.decisions), seconds > 0.0 ? bot.decisions / seconds : 0.0,
+		static_cast<unsigned long long>(replay.events.size()), static_cast<unsigned long long>(bot.rollouts),
+		static_cast<unsigned long long>(bot.simulatedTicks));
+
+	if (replayPath) {
+		replay.ticks = world.tick;
+		replay.finalHash = runningHash;
+		if (!replay.save(replayPath)) {
+			fprintf(stderr, "can't write %s\n", replayPath);
+			return 2;
+		}
+	}
+	return 0;
+}
+
+// Keep a pool topped up with short-lived bursts, as a stream of contacts would,
+// and time emit + update per 60 Hz frame; returns the process exit code
+static int runParticles(size_t target, long frames) {
+	ParticlePool pool(target + target / 4);
+	double total = 0.0, worst = 0.0;
+	size_t peak = 0;
+
+	for (long f = 0; f < frames; f++) {
+		auto start = std::chrono::steady_clock::now();
+		while (pool.count() < target) {
+			pool.emit(pool.rng.range(0.0f, 3.0f), pool.rng.range(0.0f, 1.0f), 64, 0.8f, 1.0f, particleColor(255, 220, 0));
+		}
+		pool.update(SIM_STEP);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		total += ms;
+		worst = std::max(worst, ms);
+		peak = std::max(peak, pool.count());
+	}
+
+	double mean = frames > 0 ? total / frames : 0.0;
+	printf("particles: %zu live target, %zu peak, capacity %zu, %ld frames\n", target, peak, pool.capacity(), frames);
+	printf("frame: %.3f ms mean, %.3f ms worst (%.1f%% of a 60 Hz frame), %.2f ns per particle\n",
+		mean, worst, mean / (1000.0 / 60.0) * 100.0, target > 0 ? mean * 1e6 / target : 0.0);
+	return 0;
+}
+
+
+int main(int argc, char** argv) {
+	if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+		const char* tracePath = (argc > 4 && strcmp(argv[3], "--trace") == 0) ? argv[4] : nullptr;
+		return runReplay(argv[2], tracePath);
+	}
+	if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+		return runBatch(argc, argv);
+	}
+	if (argc > 1 && strcmp(argv[1], "--autoplay") == 0) {
+		long maxTicks = (argc > 2) ? atol(argv[2]) : 100000;
+		uint64_t seed = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 1u;
+		return runAutoplay(maxTicks, seed, (argc > 4) ? argv[4] : nullptr);
+	}
+	if (argc > 1 && strcmp(argv[1], "--particles") == 0) {
+		size_t live = (argc > 2) ? static_cast<size_t>(strtoul(argv[2], nullptr, 10)) : 100000;
+		long frames = (argc > 3) ? atol(argv[3]) : 3600;
+		return runParticles(live, frames);
+	}
+
+	long maxTicks = (argc > 1) ? atol(argv[1]) : 100000; // Default is far past the 90 s game clock
+	uint64_t seed = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1u;
+	float dt = (argc > 3) ? static_cast<float>(atof(argv[3])) : SIM_STEP; // Larger steps trade precision for throughput
+	if (dt <= 0.0f) {
+		dt = SIM_STEP;
+	}
+
+	GameWorld world(seed);
+
+	auto start = std::chrono::steady_clock::now();
+	long ticks = 0;
+	while (ticks < maxTicks && world.gameState == 0) {
+		world.step(dt);
+		ticks++;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	printSummary(world, ticks, dt, std::chrono::duration<double>(end - start).count());
+	return 0;
+}
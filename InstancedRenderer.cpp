@@ -0,0 +1,273 @@
+#include "InstancedRenderer.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "GLBuffers.h"
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+
+
+// Shader and instancing entry points: GL 2.0 for the program, GL 3.3 or the
+// ARB extensions for the divisor and the instanced draw
+struct InstancingApi {
+	GLuint (APIENTRY* createShader)(GLenum type);
+	void (APIENTRY* shaderSource)(GLuint shader, GLsizei count, const char* const* strings, const GLint* lengths);
+	void (APIENTRY* compileShader)(GLuint shader);
+	void (APIENTRY* getShaderiv)(GLuint shader, GLenum name, GLint* value);
+	void (APIENTRY* deleteShader)(GLuint shader);
+	GLuint (APIENTRY* createProgram)();
+	void (APIENTRY* attachShader)(GLuint program, GLuint shader);
+	void (APIENTRY* bindAttribLocation)(GLuint program, GLuint index, const char* name);
+	void (APIENTRY* linkProgram)(GLuint program);
+	void (APIENTRY* getProgramiv)(GLuint program, GLenum name, GLint* value);
+	void (APIENTRY* useProgram)(GLuint program);
+	void (APIENTRY* deleteProgram)(GLuint program);
+	void (APIENTRY* enableVertexAttribArray)(GLuint index);
+	void (APIENTRY* disableVertexAttribArray)(GLuint index);
+	void (APIENTRY* vertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+	void (APIENTRY* vertexAttribDivisor)(GLuint index, GLuint divisor);
+	void (APIENTRY* drawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+};
+
+template <typename T>
+static bool lookup(T& proc, const char* name) {
+	proc = reinterpret_cast<T>(lookupGL(name));
+	return proc != nullptr;
+}
+
+static bool loadInstancingApi(InstancingApi& api) {
+	int version = glVersion();
+	bool divisor = version >= 33 || hasGLExtension("GL_ARB_instanced_arrays");
+	bool draw = version >= 31 || hasGLExtension("GL_ARB_draw_instanced");
+	if (version < 20 || !divisor || !draw || !bufferApi()) {
+		return false;
+	}
+	bool ok = lookup(api.createShader, "glCreateShader") && lookup(api.shaderSource, "glShaderSource") &&
+		lookup(api.compileShader, "glCompileShader") && lookup(api.getShaderiv, "glGetShaderiv") &&
+		lookup(api.deleteShader, "glDeleteShader") && lookup(api.createProgram, "glCreateProgram") &&
+		lookup(api.attachShader, "glAttachShader") && lookup(api.bindAttribLocation, "glBindAttribLocation") &&
+		lookup(api.linkProgram, "glLinkProgram") && lookup(api.getProgramiv, "glGetProgramiv") &&
+		lookup(api.useProgram, "glUseProgram") && lookup(api.deleteProgram, "glDeleteProgram") &&
+		lookup(api.enableVertexAttribArray, "glEnableVertexAttribArray") &&
+		lookup(api.disableVertexAttribArray, "glDisableVertexAttribArray") &&
+		lookup(api.vertexAttribPointer, "glVertexAttribPointer");
+	ok = ok && lookup(api.vertexAttribDivisor, version >= 33 ? "glVertexAttribDivisor" : "glVertexAttribDivisorARB");
+	ok = ok && lookup(api.drawArraysInstanced, version >= 31 ? "glDrawArraysInstanced" : "glDrawArraysInstancedARB");
+	return ok;
+}
+
+static const InstancingApi* instancingApi() {
+	static InstancingApi api;
+	static int state = 0; // 0 not looked up yet, 1 available, -1 unavailable
+	if (state == 0) {
+		state = loadInstancingApi(api) ? 1 : -1;
+	}
+	return state > 0 ? &api : nullptr;
+}
+
+// Attribute slots; 0 is the position so it aliases gl_Vertex on compatibility contexts
+enum { ATTRIB_POSITION, ATTRIB_COLOR, ATTRIB_PLACEMENT, ATTRIB_ROTATION, ATTRIB_TINT };
+
+static const char* vertexSource =
+	"#version 120\n"
+	"attribute vec2 position;\n"
+	"attribute vec4 color;\n"
+	"attribute vec4 placement;\n" // x, y, sx, sy
+	"attribute float rotation;\n"
+	"attribute vec4 tint;\n"
+	"varying vec4 shade;\n"
+	"void main() {\n"
+	"	vec2 p = position * placement.zw;\n"
+	"	float c = cos(rotation), s = sin(rotation);\n"
+	"	p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + placement.xy;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 0.0, 1.0);\n"
+	"	shade = color * tint;\n"
+	"}\n";
+
+static const char* fragmentSource =
+	"#version 120\n"
+	"varying vec4 shade;\n"
+	"void main() {\n"
+	"	gl_FragColor = shade;\n"
+	"}\n";
+
+static GLuint compile(const InstancingApi* gl, GLenum type, const char* source) {
+	GLuint shader = gl->createShader(type);
+	gl->shaderSource(shader, 1, &source, nullptr);
+	gl->compileShader(shader);
+	GLint status = 0;
+	gl->getShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		gl->deleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+
+InstancedRenderer::InstancedRenderer()
+	: meshBuffer(0), instanceBuffer(0), program(0), programState(0), meshStale(false),
+	recordedWidth(0), recordedHeight(0) {
+}
+
+InstancedRenderer::~InstancedRenderer() {
+	if (program != 0) {
+		instancingApi()->deleteProgram(program);
+	}
+	if (meshBuffer != 0) {
+		bufferApi()->deleteBuffers(1, &meshBuffer);
+	}
+	if (instanceBuffer != 0) {
+		bufferApi()->deleteBuffers(1, &instanceBuffer);
+	}
+}
+
+bool InstancedRenderer::needsRecording() const {
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	return recordedWidth == 0 || viewport[2] != recordedWidth || viewport[3] != recordedHeight;
+}
+
+void InstancedRenderer::capture(BatchRenderer& batch) {
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	recordedWidth = viewport[2];
+	recordedHeight = viewport[3];
+	mesh.assign(batch.vertices.begin(), batch.vertices.end());
+	meshVertices = mesh.size();
+	meshStale = true;
+	batch.vertices.clear();
+}
+
+void InstancedRenderer::flush() {
+	drawnInstances = instances.size();
+	if (!instances.empty() && !mesh.empty()) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		usedInstancing = allowInstancing && setUp();
+		if (usedInstancing) {
+			drawInstanced();
+		}
+		else {
+			drawExpanded();
+		}
+		glDisable(GL_BLEND);
+	}
+	instances.clear();
+}
+
+bool InstancedRenderer::setUp() {
+	if (programState == 0) {
+		programState = -1;
+		const InstancingApi* gl = instancingApi();
+		if (!gl) {
+			return false;
+		}
+		GLuint vertex = compile(gl, GL_VERTEX_SHADER, vertexSource);
+		GLuint fragment = compile(gl, GL_FRAGMENT_SHADER, fragmentSource);
+		if (vertex != 0 && fragment != 0) {
+			program = gl->createProgram();
+			gl->attachShader(program, vertex);
+			gl->attachShader(program, fragment);
+			gl->bindAttribLocation(program, ATTRIB_POSITION, "position");
+			gl->bindAttribLocation(program, ATTRIB_COLOR, "color");
+			gl->bindAttribLocation(program, ATTRIB_PLACEMENT, "placement");
+			gl->bindAttribLocation(program, ATTRIB_ROTATION, "rotation");
+			gl->bindAttribLocation(program, ATTRIB_TINT, "tint");
+			gl->linkProgram(program);
+			GLint linked = 0;
+			gl->getProgramiv(program, GL_LINK_STATUS, &linked);
+			if (linked) {
+				programState = 1;
+			}
+			else {
+				gl->deleteProgram(program);
+				program = 0;
+			}
+		}
+		if (vertex != 0) {
+			gl->deleteShader(vertex); // Freed with the program once attached
+		}
+		if (fragment != 0) {
+			gl->deleteShader(fragment);
+		}
+		if (programState > 0) {
+			bufferApi()->genBuffers(1, &meshBuffer);
+			bufferApi()->genBuffers(1, &instanceBuffer);
+		}
+	}
+	return programState > 0;
+}
+
+void InstancedRenderer::drawInstanced() {
+	const InstancingApi* gl = instancingApi();
+	const BufferApi* buffers = bufferApi();
+
+	buffers->bindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+	if (meshStale) {
+		buffers->bufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(mesh.size() * sizeof(BatchVertex)), mesh.data(), GL_STATIC_DRAW);
+		meshStale = false;
+	}
+	const char* base = nullptr; // Offsets into the bound buffer
+	gl->vertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), base);
+	gl->vertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BatchVertex), base + offsetof(BatchVertex, color));
+
+	buffers->bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	buffers->bufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(instances.size() * sizeof(SpriteInstance)), instances.data(), GL_STREAM_DRAW);
+	gl->vertexAttribPointer(ATTRIB_PLACEMENT, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), base);
+	gl->vertexAttribPointer(ATTRIB_ROTATION, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), base + offsetof(SpriteInstance, rotation));
+	gl->vertexAttribPointer(ATTRIB_TINT, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), base + offsetof(SpriteInstance, tint));
+	for (GLuint a = ATTRIB_POSITION; a <= ATTRIB_TINT; a++) {
+		gl->enableVertexAttribArray(a);
+		gl->vertexAttribDivisor(a, a >= ATTRIB_PLACEMENT ? 1 : 0);
+	}
+
+	gl->useProgram(program);
+	gl->drawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(mesh.size()), static_cast<GLsizei>(instances.size()));
+	gl->useProgram(0);
+
+	for (GLuint a = ATTRIB_POSITION; a <= ATTRIB_TINT; a++) {
+		gl->vertexAttribDivisor(a, 0); // Divisors stick to the slot, so leave them as fixed-function draws expect
+		gl->disableVertexAttribArray(a);
+	}
+	buffers->bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Same transform as the shader, one instance at a time into a single array
+void InstancedRenderer::drawExpanded() {
+	expanded.resize(mesh.size() * instances.size());
+	BatchVertex* out = expanded.data();
+	for (const SpriteInstance& s : instances) {
+		float c = cosf(s.rotation), sn = sinf(s.rotation);
+		float a = c * s.sx, b = sn * s.sx, cc = -sn * s.sy, d = c * s.sy;
+		unsigned char tint[4];
+		memcpy(tint, &s.tint, sizeof(tint));
+		for (const BatchVertex& v : mesh) {
+			out->x = a * v.x + cc * v.y + s.x;
+			out->y = b * v.x + d * v.y + s.y;
+			out->color = v.color;
+			if (s.tint != SPRITE_WHITE) {
+				unsigned char rgba[4];
+				memcpy(rgba, &v.color, sizeof(rgba));
+				for (int k = 0; k < 4; k++) {
+					rgba[k] = static_cast<unsigned char>((rgba[k] * tint[k] + 127) / 255);
+				}
+				memcpy(&out->color, rgba, sizeof(rgba));
+			}
+			out++;
+		}
+	}
+	BatchRenderer::drawArrays(reinterpret_cast<const char*>(expanded.data()), expanded.size());
+}
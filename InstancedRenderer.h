@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BatchRenderer.h"
+
+// One mesh drawn many times. The mesh is recorded once through a BatchRenderer,
+// like a StaticLayer; each frame the owner appends one compact instance per
+// entity and flush() draws them all in a single instanced call: the mesh sits
+// in a static vertex buffer, the instances are streamed into a second one, and
+// a small vertex shader places each copy.
+//
+// Instancing needs GL 2.0 shaders plus ARB_instanced_arrays (core in 3.3).
+// Without them, or with allowInstancing off, flush() expands the instances on
+// the CPU into one triangle array and draws that instead, which is the same
+// picture for the same single draw call.
+
+struct SpriteInstance {
+	float x, y;     // Where the mesh origin goes
+	float sx, sy;   // Scale along the mesh's own axes
+	float rotation; // Radians counter-clockwise, applied after the scale
+	uint32_t tint;  // RGBA bytes multiplied into the mesh colors; SPRITE_WHITE leaves them
+};
+
+const uint32_t SPRITE_WHITE = 0xffffffffu;
+
+class InstancedRenderer {
+public:
+	std::vector<SpriteInstance> instances; // This frame's, drawn and cleared by flush()
+	bool allowInstancing = true;          // False always expands on the CPU
+
+	// Stats
+	size_t meshVertices = 0;   // Triangles' vertices in one copy
+	size_t drawnInstances = 0; // In the last flush
+	bool usedInstancing = false; // Whether the last flush went through the shader
+
+	InstancedRenderer();
+	~InstancedRenderer();
+
+	// As for StaticLayer: before the first capture, and after a viewport resize,
+	// since line widths in the mesh are fixed in pixels when it is recorded
+	bool needsRecording() const;
+
+	// Takes everything appended to the batch since its last flush as the mesh,
+	// in mesh coordinates; the batch is left empty
+	void capture(BatchRenderer& batch);
+
+	void add(float x, float y, float sx = 1.0f, float sy = 1.0f, float rotation = 0.0f, uint32_t tint = SPRITE_WHITE) {
+		SpriteInstance s = { x, y, sx, sy, rotation, tint };
+		instances.push_back(s);
+	}
+
+	void flush(); // Blended, in instance order, then clears the instances
+
+private:
+	std::vector<BatchVertex> mesh;     // Kept for the CPU path
+	std::vector<BatchVertex> expanded; // CPU path's scratch, reused each frame
+	GLuint meshBuffer;
+	GLuint instanceBuffer;
+	GLuint program;
+	int programState; // 0 not tried yet, 1 ready, -1 unavailable
+	bool meshStale;   // Captured since the last upload
+	GLint recordedWidth, recordedHeight;
+
+	bool setUp(); // Program and buffers on first use; false if instancing is unavailable
+	void drawInstanced();
+	void drawExpanded();
+};
@@ -1,7 +1,9 @@
 #include <cstdio>
+#include <cstring>
 #include <glut.h>
 #include <cmath>
-#include <cstdlib>  // For rand()
+#include <algorithm>
+#include <cstdlib>  // For srand()
 #include <ctime>
 #include <vector>
 #include <string>
@@ -11,6 +13,18 @@
 #include <fstream>
 #include <thread>
 
+#include "Autoplay.h"
+#include "BatchRenderer.h"
+#include "GameWorld.h"
+#include "GlyphAtlas.h"
+#include "InstancedRenderer.h"
+#include "ParticlePool.h"
+#include "Rollback.h"
+#include "ShapeCache.h"
+#include "SimClock.h"
+#include "Snapshot.h"
+#include "StaticLayer.h"
+
 
 // Function to initialize OpenAL
 ALCdevice* device;
@@ -188,359 +202,249 @@ void cleanupOpenAL() {
 
 
 
-float speed = 0.01f; // Control the speed of movement (adjust as needed)
+GameWorld world; // All gameplay state; this file only renders it and feeds it input
 
+SimClock simClock(SIM_STEP); // Paces world steps against real time; P pauses, +/- scale, F fast-forwards
 
+const char* REPLAY_PATH = "last_game.replay"; // Overwritten at the end of every game; play it with HeadlessSim --replay
+Replay recording; // Seed and every key press of the current game
+uint64_t recordingHash = 0; // Running state hash, stored with the replay for verification
+bool recordingSaved = false;
+bool recordingHashValid = true; // A rewind breaks the running hash, but the inputs still replay
 
-class Player {
-public:
-	float x, y; // Player position
-	float width, height; // Player size
-	float jumpHeight; // Height for jump
-	bool isJumping; // Flag for jump state
-	bool isDucking; // Flag for duck state
-	float duckStartTime; // Time when ducking started
-	float jumpStartTime; // Time when jumping started
-	float maxJumpHeight = 0.3f; // Maximum height during the jump
-	bool invincible; // New attribute for invincibility
+RollbackHistory history; // Recent world states; F6 rewinds one second
+const uint32_t REWIND_TICKS = 60;
 
-	Player(float initX, float initY, float w, float h);
-	void draw(); // Render the player
-	void jump(); // Handle jumping
-	void duck(); // Handle ducking
-	void update(); // Update player state
-};
+Autoplayer autoplayer; // A toggles it; its presses are recorded like keys
+bool autoplay = false;
+
+const char* QUICKSAVE_PATH = "quicksave.snapshot"; // F5 saves, F9 loads, --resume loads it at startup
+
+// Cosmetic animations: driven by world.time so they follow pause and scale, but
+// not part of the world, so snapshots and replays never see them
+enum FxTween { FX_COLLECTABLE_SPIN, FX_POWERUP_BOB };
+TweenSystem fxTweens;
+float collectableSpin = 0.0f; // Degrees around the Y-axis
+float powerUpBob = 0.0f;      // Vertical offset
+
+BatchRenderer batch; // Every shape is appended here and drawn in a few calls per frame
+const ShapeCache shapes; // Round outlines, tessellated once at startup
+
+ParticlePool particles; // Bursts from this step's contacts; X fills it for a stress test
+const size_t PARTICLE_STRESS_COUNT = 100000;
+
+// One burst per contact, from where it happened
+void emitContactParticles() {
+	for (const Contact& c : world.contacts) {
+		switch (c.type) {
+		case CONTACT_OBSTACLE:
+			particles.emit(c.x, c.y, 96, 0.8f, 0.6f, particleColor(230, 40, 30));
+			break;
+		case CONTACT_COLLECTABLE:
+			particles.emit(c.x, c.y, 64, 0.5f, 0.8f, particleColor(255, 220, 0));
+			break;
+		default:
+			particles.emit(c.x, c.y, 48, 0.4f, 0.8f, particleColor(120, 200, 255));
+			break;
+		}
+	}
+}
+
+// The whole pool in one vertex-array draw
+void drawParticles() {
+	if (particles.count() == 0) {
+		return;
+	}
+	glPointSize(3.0f);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, particles.position.data());
+	glColorPointer(4, GL_UNSIGNED_BYTE, 0, particles.color.data());
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(particles.count()));
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glPointSize(1.0f);
+}
+
+void startFxTweens() {
+	fxTweens.clear();
+	fxTweens.add(FX_COLLECTABLE_SPIN, 0, 0.0f, 360.0f, 0.0f, 6.0f, EASE_LINEAR, TWEEN_LOOP);
+	// Smoothstep up and back over pi seconds, the period of the old sin(2t) bob; started a quarter early so it begins level
+	fxTweens.add(FX_POWERUP_BOB, 0, -0.01f, 0.01f, -0.25f * 3.14159f, 3.14159f, EASE_SMOOTH, TWEEN_PINGPONG | TWEEN_LOOP);
+}
+
+void updateFxTweens() {
+	fxTweens.evaluate(world.time);
+	for (size_t i = 0; i < fxTweens.count(); i++) {
+		switch (fxTweens.kind[i]) {
+		case FX_COLLECTABLE_SPIN: collectableSpin = fxTweens.value[i]; break;
+		case FX_POWERUP_BOB: powerUpBob = fxTweens.value[i]; break;
+		}
+	}
+}
 
-Player::Player(float initX, float initY, float w, float h)
-	: x(initX), y(initY), width(w), height(h), jumpHeight(0.0f),
-	isJumping(false), isDucking(false), duckStartTime(0.0f), jumpStartTime(0.0f), invincible(false) {}
 
 
 void Player::draw() {
 	// Body (a simple square or rectangle depending on state)
 	if (isDucking) {
-		height = 0.05f; // Height when ducking
-		width = 0.1f; // Wider when ducking
-		glColor3f(0.50, 1.0, 0.50); // Different color for ducking
+		batch.color(0.50, 1.0, 0.50); // Different color for ducking
 	}
 	else if (isJumping) {
-		height = 0.1f; // Maintain constant height while jumping
-		glColor3f(1.0, 0.50, 0.50); // Color while jumping
+		batch.color(1.0, 0.50, 0.50); // Color while jumping
 	}
 	else {
-		height = 0.1f; // Normal height
-		glColor3f(1.0, 0.50, 0.50); // Color while idle
+		batch.color(1.0, 0.50, 0.50); // Color while idle
 	}
 
-	glBegin(GL_POLYGON);
-	glVertex2f(x, y); // Bottom-left
-	glVertex2f(x + width, y); // Bottom-right
-	glVertex2f(x + width, y + height); // Top-right
-	glVertex2f(x, y + height); // Top-left
-	glEnd();
+	batch.begin(GL_POLYGON);
+	batch.vertex(x, y); // Bottom-left
+	batch.vertex(x + width, y); // Bottom-right
+	batch.vertex(x + width, y + height); // Top-right
+	batch.vertex(x, y + height); // Top-left
+	batch.end();
 
 	// Eyes (two small squares)
-	glColor3f(0.0, 1.0, 1.0); // White color for the eyes
+	batch.color(0.0, 1.0, 1.0); // White color for the eyes
 	float eyeSize = 0.02f; // Size of the eyes
 	float eyeY = y + height * 0.60f; // Y position for the eyes
-	glLineWidth(3.0f);
+	batch.lineWidth(3.0f);
 	// Left eye
-	glBegin(GL_LINES);
-	glVertex2f(x + width * 0.25f - eyeSize / 2, eyeY);
+	batch.begin(GL_LINES);
+	batch.vertex(x + width * 0.25f - eyeSize / 2, eyeY);
 
-	glVertex2f(x + width * 0.25f + eyeSize / 2, eyeY + eyeSize); // Top-right
+	batch.vertex(x + width * 0.25f + eyeSize / 2, eyeY + eyeSize); // Top-right
 
-	glEnd();
-	glBegin(GL_LINES);
-	glVertex2f(x + width * 0.25f - eyeSize / 2, eyeY + eyeSize);
-	glVertex2f(x + width * 0.25f + eyeSize / 2, eyeY);
+	batch.end();
+	batch.begin(GL_LINES);
+	batch.vertex(x + width * 0.25f - eyeSize / 2, eyeY + eyeSize);
+	batch.vertex(x + width * 0.25f + eyeSize / 2, eyeY);
 
-	glEnd();
-	glLineWidth(1.0f);
+	batch.end();
+	batch.lineWidth(1.0f);
 	// Right eye
-	glBegin(GL_QUADS);
-	glVertex2f(x + width * 0.75f - eyeSize / 2, eyeY); // Bottom-left
-	glVertex2f(x + width * 0.75f + eyeSize / 2, eyeY); // Bottom-right
-	glVertex2f(x + width * 0.75f + eyeSize / 2, eyeY + eyeSize); // Top-right
-	glVertex2f(x + width * 0.75f - eyeSize / 2, eyeY + eyeSize); // Top-left
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(x + width * 0.75f - eyeSize / 2, eyeY); // Bottom-left
+	batch.vertex(x + width * 0.75f + eyeSize / 2, eyeY); // Bottom-right
+	batch.vertex(x + width * 0.75f + eyeSize / 2, eyeY + eyeSize); // Top-right
+	batch.vertex(x + width * 0.75f - eyeSize / 2, eyeY + eyeSize); // Top-left
+	batch.end();
 
 	// Mouth (a simple rectangle)
-	glBegin(GL_LINE_LOOP);
-	glVertex2f(x + width * 0.25f, y + height * 0.3f); // Bottom-left
-	glVertex2f(x + width * 0.75f, y + height * 0.3f); // Bottom-right
-	glVertex2f(x + width * 0.75f, y + height * 0.45f); // Top-right
-	glVertex2f(x + width * 0.25f, y + height * 0.45f); // Top-left
-	glEnd();
+	batch.begin(GL_LINE_LOOP);
+	batch.vertex(x + width * 0.25f, y + height * 0.3f); // Bottom-left
+	batch.vertex(x + width * 0.75f, y + height * 0.3f); // Bottom-right
+	batch.vertex(x + width * 0.75f, y + height * 0.45f); // Top-right
+	batch.vertex(x + width * 0.25f, y + height * 0.45f); // Top-left
+	batch.end();
 }
 
-void Player::jump() {
-	if (!isJumping) {
-		isJumping = true; // Start jumping
-		jumpStartTime = glutGet(GLUT_ELAPSED_TIME) / 500.0f; // Record the time the jump starts
-	}
-}
-
-void Player::duck() {
-	if (!isDucking) {
-		isDucking = true; // Start ducking
-		duckStartTime = glutGet(GLUT_ELAPSED_TIME) / 500.0f; // Record the current time in seconds
-	}
-}
-
-void Player::update() {
-	if (isJumping) {
-		// Calculate elapsed time since the jump started
-		float currentTime = glutGet(GLUT_ELAPSED_TIME) / 500.0f;
-		float elapsedTime = currentTime - jumpStartTime;
-
-		if (elapsedTime <= 1.5f) {
-			// Phase 1: Ascend smoothly for the first 1.5 seconds
-			float progress = elapsedTime / 1.5f; // Progress from 0 to 1 over 1.5 seconds
-			y = 0.05f + progress * maxJumpHeight; // Gradually increase y (smooth ascent)
-		}
-		else if (elapsedTime <= 3.0f) {
-			// Phase 2: Descend smoothly for the next 1.5 seconds
-			float progress = (elapsedTime - 1.5f) / 1.5f; // Progress from 0 to 1 over the second 1.5 seconds
-			y = 0.05f + (1.0f - progress) * maxJumpHeight; // Gradually decrease y (smooth descent)
-		}
-		else {
-			// Jump complete: reset jumping state and position
-			isJumping = false;
-			y = 0.05f; // Reset to ground level
-		}
-	}
-
-	// Stop ducking after 1 second
-	if (isDucking) {
-		float currentTime = glutGet(GLUT_ELAPSED_TIME) / 500.0f; // Current time in seconds
-		if (currentTime - duckStartTime >= 1.0f) {
-			isDucking = false; // Stop ducking
-			width = 0.1f; // Reset width to original
-			height = 0.1f; // Reset height to original
-		}
-	}
-}
-
-
-
-
-
-
-class Obstacle {
-public:
-	float x, y;
-	float width, height;
-
-	// Variables for the animation
-	bool isAnimating = false; // Animation state
-	float initialX = 0.0f;            // Initial X position
-	float targetX = 0.0f;             // Target X position
-	float animationStartTime = 0.0f;  // Start time for animation
-	bool hitPlayer = false; // To track recent collision
-	float hitTime = 0.0f;
-
-	Obstacle(float initX, float initY, float w, float h);
-	void draw();
-	void move(float speed);
-	void startMoveBackAnimation(); // Initiate the animation
-	void updateAnimation(float currentTime); // Update the animation state
-	void updateHitStatus(float currentTime); // Reset hitPlayer after 0.5 seconds
-};
-
-
-Obstacle::Obstacle(float initX, float initY, float w, float h) : x(initX), y(initY), width(w), height(h) {}
-
-
-void Obstacle::draw() {
+void drawObstacle(float x, float y, float width, float height) {
 	// Draw the screw head (shorter height)
-	glColor3f(0.5, 0.5, 0.5); // Gray color for the screw head
-	glBegin(GL_QUADS);
-	glVertex2f(x, y - height * 0.3f);                          // Bottom-left of the screw head
-	glVertex2f(x + width * 0.2f, y - height * 0.3f);          // Bottom-right of the screw head
-	glVertex2f(x + width * 0.2f, y + height * 0.5f); // Top-right of the screw head (shorter height)
-	glVertex2f(x, y + height * 0.5f);                 // Top-left of the screw head
-	glEnd();
+	batch.color(0.5, 0.5, 0.5); // Gray color for the screw head
+	batch.begin(GL_QUADS);
+	batch.vertex(x, y - height * 0.3f);                          // Bottom-left of the screw head
+	batch.vertex(x + width * 0.2f, y - height * 0.3f);          // Bottom-right of the screw head
+	batch.vertex(x + width * 0.2f, y + height * 0.5f); // Top-right of the screw head (shorter height)
+	batch.vertex(x, y + height * 0.5f);                 // Top-left of the screw head
+	batch.end();
 
 	// Draw the screw body (wider width, same height)
-	glColor3f(0.3, 0.3, 0.3); // Darker gray color for the screw body
-	glBegin(GL_POLYGON);
-	glVertex2f(x - width * 1.5f, y + height * 0.2f);                 // Bottom-left of the screw body (wider)
-	glVertex2f(x, y + height * 0.2f);                                 // Bottom-right of the screw body
-	glVertex2f(x, y + height * 0.05f);                 // Top-right of the screw body (same height)
-	glVertex2f(x - width * 1.5f, y + height * 0.05f); // Top-left of the screw body
-	glEnd();
-}
-
-void Obstacle::startMoveBackAnimation() {
-	isAnimating = true;
-	initialX = x;               // Save the current position
-	targetX = x + 0.5f;         // Set the target position
-	animationStartTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f; // Start time in seconds
-}
-
-// Update the animation state
-void Obstacle::updateAnimation(float currentTime) {
-	if (isAnimating) {
-		float elapsed = currentTime - animationStartTime; // Elapsed time
-
-		if (elapsed >= 1.0f) { // Animation complete after 0.5 seconds
-			x = targetX; // Ensure the obstacle reaches the target position
-			isAnimating = false; // Stop animation
-		}
-		else {
-			// Interpolate the X position based on elapsed time (smooth movement)
-			float t = elapsed / 1.0f; // Normalize time between 0 and 1
-			x = initialX + t * (targetX - initialX); // Linear interpolation
-		}
-	}
-}
-void Obstacle::updateHitStatus(float currentTime) {
-	if (hitPlayer && (currentTime - hitTime >= 0.5f)) {
-		hitPlayer = false; // Reset hitPlayer after 0.5 seconds
-	}
-}
-
-
-
-
-
-void Obstacle::move(float speed) {
-	// Move the obstacle leftwards towards the player
-	x -= speed;
-}
-int i = 0;
-
-class Collectable {
-public:
-	float x, y;
-	float radius;
-
-	Collectable(float initX, float initY, float r);
-	void draw();
-	void move(float speed);
-};
-
-Collectable::Collectable(float initX, float initY, float r) : x(initX), y(initY), radius(r) {}
-
-void Collectable::draw() {
-	int sides = 20; // Use 6 for hexagon or 8 for octagon
+	batch.color(0.3, 0.3, 0.3); // Darker gray color for the screw body
+	batch.begin(GL_POLYGON);
+	batch.vertex(x - width * 1.5f, y + height * 0.2f);                 // Bottom-left of the screw body (wider)
+	batch.vertex(x, y + height * 0.2f);                                 // Bottom-right of the screw body
+	batch.vertex(x, y + height * 0.05f);                 // Top-right of the screw body (same height)
+	batch.vertex(x - width * 1.5f, y + height * 0.05f); // Top-left of the screw body
+	batch.end();
+}
+
+// Facing the viewer, centered on the origin; the spin and position are per instance
+// A coin is drawn in three layers: face, outline, slot. The face and slot are
+// instance meshes; the outline is not, since a 2 px line recorded into a mesh
+// would narrow with the spin's x scale instead of staying 2 px wide.
+void drawCollectable(float radius) {
 	// Yellow color for the coin
-	glColor3f(0.9, 0.9, 0.0);
-
-	// Save the current transformation matrix
-	glPushMatrix();
-
-	// Move to the center of the collectable
-	glTranslatef(x, y, 0.0f);
-
-	// Rotate around the Y-axis for a horizontal spin
-	static float angle = 0.0f; // Static to accumulate the rotation angle over time
-	glRotatef(angle, 0.0f, 1.0f, 0.0f); // Rotation around Y-axis
-
-	// Increment the angle to make it spin (adjust the value for speed control)
-	angle += 1.0f;
+	batch.color(0.9, 0.9, 0.0);
 
 	// Draw the outer shape (hexagon or octagon)
-	glBegin(GL_POLYGON);
-	for (int i = 0; i < sides; i++) {
-		float theta = 2.0f * 3.14159f * float(i) / float(sides); // Angle for each vertex
-		glVertex3f((radius * 1.5f) * 0.7 * cosf(theta), (radius * 1.5f) * 0.5 * sinf(theta), 0.0f); // Calculate vertex position
-	}
-	glEnd();
+	batch.begin(GL_POLYGON);
+	batch.appendShape(shapes.circle20, 0.0f, 0.0f, (radius * 1.5f) * 0.7f, (radius * 1.5f) * 0.5f); // Twenty sides, tessellated once
+	batch.end();
+}
+
+// Straight into the batch each frame, spinning around the Y-axis; the batch widens lines after the transform
+void drawCollectableOutline(float x, float y, float radius) {
+	batch.push();
+	batch.translate(x, y);
+	batch.rotateY(collectableSpin); // Rotation around Y-axis, one turn per 6 seconds
 
 	// Shiny white lines inside (creating a simple shine effect)
-	glColor3f(1.0, 1.0, 1.0); // White color for the shine lines
-	glLineWidth(2.0f);
+	batch.color(1.0, 1.0, 1.0); // White color for the shine lines
+	batch.lineWidth(2.0f);
 
 	// Draw a set of lines radiating from the center
-	glBegin(GL_LINE_LOOP); // White outline inside the shape
-	for (int i = 0; i < sides; i++) {
-		float theta = 2.0f * 3.14159f * float(i) / float(sides);
-		glVertex3f((radius * 1.5f) * 0.7 * cosf(theta), (radius * 1.5f) * 0.5 * sinf(theta), 0.0f); // Inner polygon
-	}
-	glEnd();
-
-	glLineWidth(1.0f);
+	batch.begin(GL_LINE_LOOP); // White outline inside the shape
+	batch.appendShape(shapes.circle20, 0.0f, 0.0f, (radius * 1.5f) * 0.7f, (radius * 1.5f) * 0.5f);
+	batch.end();
 
-	// Draw the slot (white rectangle in the center)
-	glColor3f(1.0, 1.0, 0.0); // Yellow color for the slot
-	glBegin(GL_QUADS);
-	glVertex3f(-radius * 0.1f, -radius * 0.5f, 0.0f); // Bottom-left
-	glVertex3f(radius * 0.1f, -radius * 0.5f, 0.0f);  // Bottom-right
-	glVertex3f(radius * 0.1f, radius * 0.5f, 0.0f);   // Top-right
-	glVertex3f(-radius * 0.1f, radius * 0.5f, 0.0f);  // Top-left
-	glEnd();
-
-	// Restore the original transformation matrix
-	glPopMatrix();
+	batch.lineWidth(1.0f);
+	batch.pop();
 }
 
-void Collectable::move(float speed) {
-	x -= speed; // Move the collectible to the left at the given speed
+void drawCollectableSlot(float radius) {
+	// Draw the slot (white rectangle in the center)
+	batch.color(1.0, 1.0, 0.0); // Yellow color for the slot
+	batch.begin(GL_QUADS);
+	batch.vertex(-radius * 0.1f, -radius * 0.5f); // Bottom-left
+	batch.vertex(radius * 0.1f, -radius * 0.5f);  // Bottom-right
+	batch.vertex(radius * 0.1f, radius * 0.5f);   // Top-right
+	batch.vertex(-radius * 0.1f, radius * 0.5f);  // Top-left
+	batch.end();
 }
 
-
-
-class PowerUp {
-public:
-	float x, y;
-	float size;
-	bool isSpeedPowerUp; // Flag to distinguish between power-up types
-
-	PowerUp(float initX, float initY, float s, bool speedPowerUp);
-	void draw();
-	void move(float speed);
-};
-
-PowerUp::PowerUp(float initX, float initY, float s, bool speedPowerUp) : x(initX), y(initY), size(s), isSpeedPowerUp(speedPowerUp) {}
-
-void PowerUp::draw() {
-
-	float animationOffset = 0.01f * sinf(glutGet(GLUT_ELAPSED_TIME) / 500.0f);
-	glPushMatrix();
-	glTranslatef(0.0f, animationOffset, 0.0f);
-
+// The bob is per instance
+void drawPowerUp(float x, float y, float size, bool isSpeedPowerUp) {
 	if (isSpeedPowerUp) {
 		// Draw a yellow lightning bolt for speed power-up
-		glColor3f(1.0, 1.0, 0.0); // Yellow color for the lightning bolt
+		batch.color(1.0, 1.0, 0.0); // Yellow color for the lightning bolt
 
 		// First right-angled triangle (top)
-		glBegin(GL_TRIANGLES);
-		glVertex2f(x, y + size); // Top vertex (at the top of the bolt)
-		glVertex2f(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
-		glVertex2f(x, y + size * 0.5f); // Mid-left vertex
-		glEnd();
+		batch.begin(GL_TRIANGLES);
+		batch.vertex(x, y + size); // Top vertex (at the top of the bolt)
+		batch.vertex(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
+		batch.vertex(x, y + size * 0.5f); // Mid-left vertex
+		batch.end();
 
 		// Second right-angled triangle (bottom, flipped to the left)
 		float shiftAmount = 0.025f; // Amount to shift the bottom triangle to the left
-		glBegin(GL_TRIANGLES);
-		glVertex2f(x + size * 0.5f - shiftAmount, y);           // Bottom-right vertex (shifted left)
-		glVertex2f(x - shiftAmount, y + size * 0.5f);           // Tip of the bottom triangle (pointing left)
-		glVertex2f(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex (shared with the top triangle, shifted left)
-		glEnd();
+		batch.begin(GL_TRIANGLES);
+		batch.vertex(x + size * 0.5f - shiftAmount, y);           // Bottom-right vertex (shifted left)
+		batch.vertex(x - shiftAmount, y + size * 0.5f);           // Tip of the bottom triangle (pointing left)
+		batch.vertex(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex (shared with the top triangle, shifted left)
+		batch.end();
 
 		// Draw a line between both triangles
-		glColor3f(1.0, 1.0, 1.0); // White color for the line
-		glBegin(GL_LINES);
-		glVertex2f(x + size * 0.25f, y + size * 0.5f); // Start at the tip of the top triangle
-		glVertex2f(x + size * 0.25f, y);         // Draw a line down to the base of the bottom triangle
-		glEnd();
+		batch.color(1.0, 1.0, 1.0); // White color for the line
+		batch.begin(GL_LINES);
+		batch.vertex(x + size * 0.25f, y + size * 0.5f); // Start at the tip of the top triangle
+		batch.vertex(x + size * 0.25f, y);         // Draw a line down to the base of the bottom triangle
+		batch.end();
 
 		// Draw outline for the top triangle
-		glColor3f(1.0, 1.0, 1.0); // White color for outline
-		glBegin(GL_LINE_LOOP); // Outline for the top triangle
-		glVertex2f(x, y + size); // Top vertex
-		glVertex2f(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
-		glVertex2f(x, y + size * 0.5f); // Mid-left vertex
-		glEnd();
+		batch.color(1.0, 1.0, 1.0); // White color for outline
+		batch.begin(GL_LINE_LOOP); // Outline for the top triangle
+		batch.vertex(x, y + size); // Top vertex
+		batch.vertex(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
+		batch.vertex(x, y + size * 0.5f); // Mid-left vertex
+		batch.end();
 
 		// Draw outline for the bottom triangle
-		glBegin(GL_LINE_LOOP); // Outline for the bottom triangle
-		glVertex2f(x + size * 0.5f - shiftAmount, y); // Bottom-right vertex (shifted left)
-		glVertex2f(x - shiftAmount, y + size * 0.5f); // Tip of the bottom triangle (pointing left)
-		glVertex2f(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex
-		glEnd();
+		batch.begin(GL_LINE_LOOP); // Outline for the bottom triangle
+		batch.vertex(x + size * 0.5f - shiftAmount, y); // Bottom-right vertex (shifted left)
+		batch.vertex(x - shiftAmount, y + size * 0.5f); // Tip of the bottom triangle (pointing left)
+		batch.vertex(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex
+		batch.end();
 	}
 	else {
 		// Amount to translate the red part to the right
@@ -548,587 +452,363 @@ void PowerUp::draw() {
 		float rectHeight = size * 0.5f; // Height for the small squares
 
 		// Draw the left part (red semicircle)
-		glColor3f(1.0, 0.0, 0.0); // Red color for the semicircle
-		glBegin(GL_POLYGON);
-		for (int i = 0; i <= 20; i++) {
-			// Adjust the angle for left-side semicircle (90 degrees to 270 degrees)
-			float theta = 3.14159f * (float(i) / 20.0f + 0.5f); // Sweep from 90 to 270 degrees
-
-			float cx = x; // Center of the left semicircle
-			float cy = y + rectHeight * 0.5f; // Center vertically (aligned with the small squares)
-
-			// Create vertices for the left semicircle
-			glVertex2f(cx + (rectHeight * 0.5f) * cosf(theta), cy + (rectHeight * 0.5f) * sinf(theta));
-		}
-		glEnd();
+		batch.color(1.0, 0.0, 0.0); // Red color for the semicircle
+		batch.begin(GL_POLYGON);
+		// Centered on the left edge, vertically aligned with the small squares; sweeps 90 to 270 degrees
+		batch.appendShape(shapes.leftHalf, x, y + rectHeight * 0.5f, rectHeight * 0.5f, rectHeight * 0.5f);
+		batch.end();
 
 		// Draw the red square (in between the semicircles)
-		glColor3f(1.0, 0.0, 0.0); // Red color for the square
-		glBegin(GL_QUADS);
-		glVertex2f(x, y);                    // Bottom-left
-		glVertex2f(x + rectWidth, y);        // Bottom-right
-		glVertex2f(x + rectWidth, y + rectHeight); // Top-right
-		glVertex2f(x, y + rectHeight);       // Top-left
-		glEnd();
+		batch.color(1.0, 0.0, 0.0); // Red color for the square
+		batch.begin(GL_QUADS);
+		batch.vertex(x, y);                    // Bottom-left
+		batch.vertex(x + rectWidth, y);        // Bottom-right
+		batch.vertex(x + rectWidth, y + rectHeight); // Top-right
+		batch.vertex(x, y + rectHeight);       // Top-left
+		batch.end();
 
 		// Draw the white square (in between the semicircles)
-		glColor3f(1.0, 1.0, 1.0); // White color for the square
-		glBegin(GL_QUADS);
-		glVertex2f(x + rectWidth, y);                    // Bottom-left
-		glVertex2f(x + rectWidth * 2.0f, y);             // Bottom-right
-		glVertex2f(x + rectWidth * 2.0f, y + rectHeight); // Top-right
-		glVertex2f(x + rectWidth, y + rectHeight);       // Top-left
-		glEnd();
+		batch.color(1.0, 1.0, 1.0); // White color for the square
+		batch.begin(GL_QUADS);
+		batch.vertex(x + rectWidth, y);                    // Bottom-left
+		batch.vertex(x + rectWidth * 2.0f, y);             // Bottom-right
+		batch.vertex(x + rectWidth * 2.0f, y + rectHeight); // Top-right
+		batch.vertex(x + rectWidth, y + rectHeight);       // Top-left
+		batch.end();
 
 		// Draw the right part (white semicircle)
-		glColor3f(1.0, 1.0, 1.0); // White color for the semicircle
-		glBegin(GL_POLYGON);
-		for (int i = 0; i <= 20; i++) {
-			// Adjust the angle for right-side semicircle (270 degrees to 450 degrees)
-			float theta = 3.14159f * (float(i) / 20.0f - 0.5f); // Sweep from 270 to 450 degrees
-
-			float cx = x + rectWidth * 2.0f; // Center of the right semicircle
-			float cy = y + rectHeight * 0.5f; // Center vertically (aligned with the small squares)
-
-			// Create vertices for the right semicircle
-			glVertex2f(cx + (rectHeight * 0.5f) * cosf(theta), cy + (rectHeight * 0.5f) * sinf(theta));
-		}
-		glEnd();
-	}
-	glPopMatrix();
-
-
-}
-
-void PowerUp::move(float speed) {
-	x -= speed; // Move the power-up to the left at the given speed
-}
-std::vector<Collectable> collectables;
-std::vector<PowerUp> powerups;
-std::vector<Obstacle> obstacles;
-
-float randomFloat(float min, float max) {
-	return min + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (max - min)));
-}
-
-// Random boolean value to determine power-up type (lightning or pill)
-bool randomPowerUpType() {
-	return rand() % 2 == 0; // Returns true for lightning, false for pill
-}
-
-float spawnCollectableTime = 11.0f; // Collectables every 10 seconds
-float spawnPowerUpTime = 13.0f;     // Power-ups every 15 seconds
-float spawnObstacleTime = 3.0f;     // Obstacles every 5 seconds
-
-// Timers to keep track of spawning time
-float collectableTimer = 0.0f;
-float powerUpTimer = 0.0f;
-float obstacleTimer = 0.0f;
-
-// Spawning logic
-void spawnCollectable() {
-	// Random y position between 0.1 and 1.0
-	float y = randomFloat(0.1f, 0.3f);
-	float radius = 0.05f; // Fixed radius for the collectable
-	collectables.push_back(Collectable(3.0f, y, radius));  // Add new collectable to vector
-	i++;
-}
-
-void spawnPowerUp() {
-	// Random y position between 0.1 and 1.0
-	float y = randomFloat(0.1f, 0.3f);
-	float size = 0.1f; // Fixed size for the power-up
-	bool isLightning = randomPowerUpType(); // Randomly decide power-up type
-	powerups.push_back(PowerUp(3.0f, y, size, isLightning));  // Add new power-up to vector
-}
-
-void spawnObstacle() {
-	// Random height and width for the obstacle
-	float w = randomFloat(0.05f, 0.15f); // Width between 0.1 and 0.3
-	float h = randomFloat(0.05f, 0.15f); // Height between 0.1 and 0.2
-	float y = randomFloat(0.1f, 0.3f); // Random y position between 0.1 and 0.6
-	obstacles.push_back(Obstacle(3.0f, y, w, h));  // Add new obstacle to vector
-}
-
-void updateTimers(float deltaTime) {
-	// Update timers
-	collectableTimer += deltaTime;
-	powerUpTimer += deltaTime;
-	obstacleTimer += deltaTime;
-
-	// Check for overlapping spawns (within a small delta, e.g., 0.2 seconds)
-	float delta = 0.2f;
-
-	// Prioritize obstacle, then collectable, then powerup
-	if (abs(obstacleTimer - collectableTimer) < delta) {
-		collectableTimer -= 1.3f; // Adjust collectable timer
-	}
-	if (abs(obstacleTimer - powerUpTimer) < delta) {
-		powerUpTimer -= 1.3f; // Adjust powerup timer
-	}
-	if (abs(collectableTimer - powerUpTimer) < delta) {
-		powerUpTimer -= 1.3f; // Adjust powerup timer
-	}
-	if (obstacleTimer >= spawnObstacleTime) {
-		spawnObstacle();
-		obstacleTimer = 0.0f; // Reset obstacle timer
-	}
-
-	if (collectableTimer >= spawnCollectableTime) {
-
-
-		spawnCollectable();
-		collectableTimer = 0.0f; // Reset collectable timer
-	}
-
-	if (powerUpTimer >= spawnPowerUpTime) {
-
-		spawnPowerUp();
-		powerUpTimer = 0.0f; // Reset powerup timer
+		batch.color(1.0, 1.0, 1.0); // White color for the semicircle
+		batch.begin(GL_POLYGON);
+		// Centered on the right edge of the white square; sweeps 270 to 450 degrees
+		batch.appendShape(shapes.rightHalf, x + rectWidth * 2.0f, y + rectHeight * 0.5f, rectHeight * 0.5f, rectHeight * 0.5f);
+		batch.end();
 	}
 }
 
-
 void drawBoundaries() {
 	// Draw upper boundary
-	glColor3f(1.0, 1.0, 1.0); // Set color to white
-	glBegin(GL_QUADS); // Upper boundary (4 primitives)
-	glVertex2f(0.0, 0.95);
-	glVertex2f(3.0, 0.95);
-	glVertex2f(3.0, 0.98);
-	glVertex2f(0.0, 0.98);
-	glEnd();
+	batch.color(1.0, 1.0, 1.0); // Set color to white
+	batch.begin(GL_QUADS); // Upper boundary (4 primitives)
+	batch.vertex(0.0, 0.95);
+	batch.vertex(3.0, 0.95);
+	batch.vertex(3.0, 0.98);
+	batch.vertex(0.0, 0.98);
+	batch.end();
 
 	// Add symmetrical squares to upper boundary (total 4 squares)
-	glColor3f(0.0, 0.0, 0.0); // Red squares
+	batch.color(0.0, 0.0, 0.0); // Red squares
 	float squareWidth = 0.07f; // Consistent square width
 
 	// First square (left side)
-	glBegin(GL_QUADS);
-	glVertex2f(0.15, 0.96);
-	glVertex2f(0.15 + squareWidth, 0.96);
-	glVertex2f(0.15 + squareWidth, 0.97);
-	glVertex2f(0.15, 0.97);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(0.15, 0.96);
+	batch.vertex(0.15 + squareWidth, 0.96);
+	batch.vertex(0.15 + squareWidth, 0.97);
+	batch.vertex(0.15, 0.97);
+	batch.end();
 
 	// Second square
-	glBegin(GL_QUADS);
-	glVertex2f(0.85, 0.96);
-	glVertex2f(0.85 + squareWidth, 0.96);
-	glVertex2f(0.85 + squareWidth, 0.97);
-	glVertex2f(0.85, 0.97);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(0.85, 0.96);
+	batch.vertex(0.85 + squareWidth, 0.96);
+	batch.vertex(0.85 + squareWidth, 0.97);
+	batch.vertex(0.85, 0.97);
+	batch.end();
 
 	// Third square (right side)
-	glBegin(GL_QUADS);
-	glVertex2f(1.55, 0.96);
-	glVertex2f(1.55 + squareWidth, 0.96);
-	glVertex2f(1.55 + squareWidth, 0.97);
-	glVertex2f(1.55, 0.97);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(1.55, 0.96);
+	batch.vertex(1.55 + squareWidth, 0.96);
+	batch.vertex(1.55 + squareWidth, 0.97);
+	batch.vertex(1.55, 0.97);
+	batch.end();
 
 	// Fourth square
-	glBegin(GL_QUADS);
-	glVertex2f(2.25, 0.96);
-	glVertex2f(2.25 + squareWidth, 0.96);
-	glVertex2f(2.25 + squareWidth, 0.97);
-	glVertex2f(2.25, 0.97);
-	glEnd();
-
-	glBegin(GL_QUADS);
-	glVertex2f(2.85, 0.96);
-	glVertex2f(2.85 + squareWidth, 0.96);
-	glVertex2f(2.85 + squareWidth, 0.97);
-	glVertex2f(2.85, 0.97);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(2.25, 0.96);
+	batch.vertex(2.25 + squareWidth, 0.96);
+	batch.vertex(2.25 + squareWidth, 0.97);
+	batch.vertex(2.25, 0.97);
+	batch.end();
+
+	batch.begin(GL_QUADS);
+	batch.vertex(2.85, 0.96);
+	batch.vertex(2.85 + squareWidth, 0.96);
+	batch.vertex(2.85 + squareWidth, 0.97);
+	batch.vertex(2.85, 0.97);
+	batch.end();
 
 	// Draw lower boundary
-	glColor3f(1.0, 1.0, 1.0); // Set color to white
-	glBegin(GL_QUADS); // Lower boundary (4 primitives)
-	glVertex2f(0.0, 0.02);
-	glVertex2f(3.0, 0.02);
-	glVertex2f(3.0, 0.05);
-	glVertex2f(0.0, 0.05);
-	glEnd();
+	batch.color(1.0, 1.0, 1.0); // Set color to white
+	batch.begin(GL_QUADS); // Lower boundary (4 primitives)
+	batch.vertex(0.0, 0.02);
+	batch.vertex(3.0, 0.02);
+	batch.vertex(3.0, 0.05);
+	batch.vertex(0.0, 0.05);
+	batch.end();
 
 	// Add symmetrical black squares to lower boundary
-	glColor3f(0.0, 0.0, 0.0); // Black squares
+	batch.color(0.0, 0.0, 0.0); // Black squares
 
 	// First square (left side)
-	glBegin(GL_QUADS);
-	glVertex2f(0.15, 0.03);
-	glVertex2f(0.15 + squareWidth, 0.03);
-	glVertex2f(0.15 + squareWidth, 0.04);
-	glVertex2f(0.15, 0.04);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(0.15, 0.03);
+	batch.vertex(0.15 + squareWidth, 0.03);
+	batch.vertex(0.15 + squareWidth, 0.04);
+	batch.vertex(0.15, 0.04);
+	batch.end();
 
 	// Second square
-	glBegin(GL_QUADS);
-	glVertex2f(0.85, 0.03);
-	glVertex2f(0.85 + squareWidth, 0.03);
-	glVertex2f(0.85 + squareWidth, 0.04);
-	glVertex2f(0.85, 0.04);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(0.85, 0.03);
+	batch.vertex(0.85 + squareWidth, 0.03);
+	batch.vertex(0.85 + squareWidth, 0.04);
+	batch.vertex(0.85, 0.04);
+	batch.end();
 
 	// Third square (right side)
-	glBegin(GL_QUADS);
-	glVertex2f(1.55, 0.03);
-	glVertex2f(1.55 + squareWidth, 0.03);
-	glVertex2f(1.55 + squareWidth, 0.04);
-	glVertex2f(1.55, 0.04);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(1.55, 0.03);
+	batch.vertex(1.55 + squareWidth, 0.03);
+	batch.vertex(1.55 + squareWidth, 0.04);
+	batch.vertex(1.55, 0.04);
+	batch.end();
 
 	// Fourth square
-	glBegin(GL_QUADS);
-	glVertex2f(2.25, 0.03);
-	glVertex2f(2.25 + squareWidth, 0.03);
-	glVertex2f(2.25 + squareWidth, 0.04);
-	glVertex2f(2.25, 0.04);
-	glEnd();
-
-	glBegin(GL_QUADS);
-	glVertex2f(2.85, 0.03);
-	glVertex2f(2.85 + squareWidth, 0.03);
-	glVertex2f(2.85 + squareWidth, 0.04);
-	glVertex2f(2.85, 0.04);
-	glEnd();
+	batch.begin(GL_QUADS);
+	batch.vertex(2.25, 0.03);
+	batch.vertex(2.25 + squareWidth, 0.03);
+	batch.vertex(2.25 + squareWidth, 0.04);
+	batch.vertex(2.25, 0.04);
+	batch.end();
+
+	batch.begin(GL_QUADS);
+	batch.vertex(2.85, 0.03);
+	batch.vertex(2.85 + squareWidth, 0.03);
+	batch.vertex(2.85 + squareWidth, 0.04);
+	batch.vertex(2.85, 0.04);
+	batch.end();
 }
 
 void drawPyramid(float xBaseLeft, float yBaseLeft, float xBaseRight, float yBaseRight, float xPeak, float yPeak, float r, float g, float b, float alpha) {
-	glColor4f(r, g, b, alpha); // Color with transparency
-	glBegin(GL_TRIANGLES);
+	batch.color(r, g, b, alpha); // Color with transparency
+	batch.begin(GL_TRIANGLES);
 
 	// Draw the triangle using the passed coordinates
-	glVertex2f(xBaseLeft, yBaseLeft);  // Base left
-	glVertex2f(xBaseRight, yBaseRight); // Base right
-	glVertex2f(xPeak, yPeak);  // Top peak
+	batch.vertex(xBaseLeft, yBaseLeft);  // Base left
+	batch.vertex(xBaseRight, yBaseRight); // Base right
+	batch.vertex(xPeak, yPeak);  // Top peak
 
-	glEnd();
+	batch.end();
 }
 
 
-void drawBoundariesAndDecorations() {
-	// Enable blending for transparency
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	// Draw boundaries
-	drawBoundaries();
-
-	// Calculate time-based shift for dancing peaks
-	float time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f; // Get time in seconds
-	float peakShift = 0.1f * sinf(time * 2.0f); // Calculate shift based on sine wave
-
-	// Adjust the size and make peaks "dance"
-	drawPyramid(0.1, 0.05, 1.2, 0.05, 0.65 + peakShift, 0.7, 0.5, 0.5, 0.5, 0.3); // First larger pyramid
-	drawPyramid(0.7, 0.05, 1.9, 0.05, 1.3 + peakShift, 0.6, 0.4, 0.4, 0.4, 0.2); // Second larger pyramid
-	drawPyramid(1.4, 0.05, 2.8, 0.05, 2.1 + peakShift, 0.65, 0.6, 0.6, 0.6, 0.2); // Third larger pyramid
-
-	// Disable blending after decorations
-	glDisable(GL_BLEND);
-}
-
-
-
-
-void drawHearts(int health) {
-	for (int i = 0; i < health; ++i) {
-		float x_offset = 0.11 * i; // Increased spacing between hearts
-
-		// Draw the white outline first (same vertices as the heart)
-		glColor3f(1.0, 1.0, 1.0); // White outline
-		glBegin(GL_LINE_LOOP);
-
-		glVertex2f(0.085 + x_offset, 0.83);  // Bottom middle vertex (the point of the heart)
-		glVertex2f(0.04 + x_offset, 0.87);   // Middle left
-		glVertex2f(0.055 + x_offset, 0.89);  // Upper left bump
-		glVertex2f(0.07 + x_offset, 0.89);   // Top left
-		glVertex2f(0.085 + x_offset, 0.88);  // Middle vertex (slightly lower than the top)
-		glVertex2f(0.10 + x_offset, 0.89);   // Top right
-		glVertex2f(0.115 + x_offset, 0.89);  // Upper right bump
-		glVertex2f(0.13 + x_offset, 0.87);   // Middle right
-
-		glEnd();
-
-		// Now draw the red heart using the same vertices
-		glColor3f(1.0, 0.0, 0.0); // Red heart
-		glBegin(GL_POLYGON);
+// The pyramids' resting shapes; their peaks sway by peakShift at run time
+struct PyramidShape {
+	float left, right, peakX, peakY; // Base corners sit on PYRAMID_BASE_Y
+	float r, g, b, alpha;
+};
+const float PYRAMID_BASE_Y = 0.05f;
+const PyramidShape pyramids[3] = {
+	{ 0.1f, 1.2f, 0.65f, 0.7f, 0.5f, 0.5f, 0.5f, 0.3f }, // First larger pyramid
+	{ 0.7f, 1.9f, 1.3f, 0.6f, 0.4f, 0.4f, 0.4f, 0.2f },  // Second larger pyramid
+	{ 1.4f, 2.8f, 2.1f, 0.65f, 0.6f, 0.6f, 0.6f, 0.2f }  // Third larger pyramid
+};
 
-		// Define the vertices to form the red heart shape
-		glVertex2f(0.085 + x_offset, 0.83);  // Bottom middle vertex (the point of the heart)
-		glVertex2f(0.04 + x_offset, 0.87);   // Middle left
-		glVertex2f(0.055 + x_offset, 0.89);  // Upper left bump
-		glVertex2f(0.07 + x_offset, 0.89);   // Top left
-		glVertex2f(0.085 + x_offset, 0.88);  // Middle vertex (slightly lower than the top)
-		glVertex2f(0.10 + x_offset, 0.89);   // Top right
-		glVertex2f(0.115 + x_offset, 0.89);  // Upper right bump
-		glVertex2f(0.13 + x_offset, 0.87);   // Middle right
+// Boundaries and pyramids never change shape, so they are recorded once and replayed each frame
+StaticLayer boundaryLayer;
+StaticLayer pyramidLayers[3];
 
-		glEnd();
+void drawBoundariesAndDecorations() {
+	if (boundaryLayer.needsRecording()) {
+		drawBoundaries();
+		boundaryLayer.capture(batch);
+		for (int i = 0; i < 3; i++) {
+			const PyramidShape& p = pyramids[i];
+			drawPyramid(p.left, PYRAMID_BASE_Y, p.right, PYRAMID_BASE_Y, p.peakX, p.peakY, p.r, p.g, p.b, p.alpha);
+			pyramidLayers[i].capture(batch);
+		}
 	}
-}
-
-
-
-
-Player player(0.7f, 0.05f, 0.1f, 0.1f);
-
+	boundaryLayer.draw();
 
+	// Calculate time-based shift for dancing peaks
+	float time = world.time; // Simulated seconds, so the peaks follow pause and scale
+	float peakShift = 0.1f * sinf(time * 2.0f); // Calculate shift based on sine wave
 
-void drawText(const char* text, float x, float y) {
-	glColor3f(1.0, 1.0, 1.0); // White text
-	glRasterPos2f(x, y);
-	for (const char* c = text; *c != '\0'; ++c) {
-		glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
-	}
+	// Shear each pyramid about its base line: the peak moves by peakShift and the base stays put
+	for (int i = 0; i < 3; i++) {
+		float shear = peakShift / (pyramids[i].peakY - PYRAMID_BASE_Y);
+		const GLfloat matrix[16] = {
+			1.0f, 0.0f, 0.0f, 0.0f,
+			shear, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			-shear * PYRAMID_BASE_Y, 0.0f, 0.0f, 1.0f
+		};
+		pyramidLayers[i].draw(matrix);
+	}
+}
+
+
+
+
+// One heart, its left edge at x_offset; the row of them is instanced
+void drawHeart(float x_offset) {
+	// Draw the white outline first (same vertices as the heart)
+	batch.color(1.0, 1.0, 1.0); // White outline
+	batch.begin(GL_LINE_LOOP);
+
+	batch.vertex(0.085 + x_offset, 0.83);  // Bottom middle vertex (the point of the heart)
+	batch.vertex(0.04 + x_offset, 0.87);   // Middle left
+	batch.vertex(0.055 + x_offset, 0.89);  // Upper left bump
+	batch.vertex(0.07 + x_offset, 0.89);   // Top left
+	batch.vertex(0.085 + x_offset, 0.88);  // Middle vertex (slightly lower than the top)
+	batch.vertex(0.10 + x_offset, 0.89);   // Top right
+	batch.vertex(0.115 + x_offset, 0.89);  // Upper right bump
+	batch.vertex(0.13 + x_offset, 0.87);   // Middle right
+
+	batch.end();
+
+	// Now draw the red heart using the same vertices
+	batch.color(1.0, 0.0, 0.0); // Red heart
+	batch.begin(GL_POLYGON);
+
+	// Define the vertices to form the red heart shape
+	batch.vertex(0.085 + x_offset, 0.83);  // Bottom middle vertex (the point of the heart)
+	batch.vertex(0.04 + x_offset, 0.87);   // Middle left
+	batch.vertex(0.055 + x_offset, 0.89);  // Upper left bump
+	batch.vertex(0.07 + x_offset, 0.89);   // Top left
+	batch.vertex(0.085 + x_offset, 0.88);  // Middle vertex (slightly lower than the top)
+	batch.vertex(0.10 + x_offset, 0.89);   // Top right
+	batch.vertex(0.115 + x_offset, 0.89);  // Upper right bump
+	batch.vertex(0.13 + x_offset, 0.87);   // Middle right
+
+	batch.end();
+}
+
+// Entities that repeat are one mesh per type, recorded once at the size they
+// spawn at and drawn with one instanced call per type each frame
+const float COIN_MESH_RADIUS = 0.05f; // Collectables' spawn radius
+const float POWERUP_MESH_SIZE = 0.1f; // Power-ups' spawn side
+InstancedRenderer obstacleSprites;   // Unit width and height, scaled per instance
+InstancedRenderer coinSprites;      // Coin faces
+InstancedRenderer coinSlotSprites;
+InstancedRenderer lightningSprites;  // Speed power-ups
+InstancedRenderer pillSprites;       // Invincibility power-ups
+InstancedRenderer heartSprites;
+
+void recordSprites() {
+	drawObstacle(0.0f, 0.0f, 1.0f, 1.0f);
+	obstacleSprites.capture(batch);
+	drawCollectable(COIN_MESH_RADIUS);
+	coinSprites.capture(batch);
+	drawCollectableSlot(COIN_MESH_RADIUS);
+	coinSlotSprites.capture(batch);
+	drawPowerUp(0.0f, 0.0f, POWERUP_MESH_SIZE, true);
+	lightningSprites.capture(batch);
+	drawPowerUp(0.0f, 0.0f, POWERUP_MESH_SIZE, false);
+	pillSprites.capture(batch);
+	drawHeart(0.0f);
+	heartSprites.capture(batch);
+}
+
+
+// Fonts read back from GLUT on the first frame, and the strings drawn with them;
+// each is laid out again only when its text changes
+GlyphAtlas hudFont;    // Helvetica 18
+GlyphAtlas bannerFont; // Times Roman 24
+TextMesh scoreText;
+TextMesh timeText;
+TextMesh bannerText;   // YOU DIED / YOU WIN
+
+void drawText(const TextMesh& text, float x, float y) {
+	batch.color(1.0, 1.0, 1.0); // White text
+	text.draw(batch, x, y);
 }
 
 void drawScoreAndTime(int score, int timeLeft) {
 	// Draw Score in the top middle
-	char scoreStr[50];
-	sprintf(scoreStr, "Score: %d", score);
-	drawText(scoreStr, 1.5f, 0.85f);  // Adjusted position for visibility
+	scoreText.setNumber(hudFont, "Score: %d", score);
+	drawText(scoreText, 1.5f, 0.85f);  // Adjusted position for visibility
 
 	// Draw Time in the top right
-	char timeStr[50];
-	sprintf(timeStr, "Time: %d", timeLeft);
-	drawText(timeStr, 2.8f, 0.85f);  // Adjusted position for visibility
-}
-
-int gameTime = 90; // Global variable for game time (2 minutes = 120 seconds)
-int gameScore = 0;
-float lastUpdateTime = 0.0f; // Global variable to track the last update time
-
-int speedIncreaseInterval = 30; // Speed increases every 30 seconds
-int lastSpeedIncreaseTime = 0; // Time when the speed was last increased
-
-
-
-int gameState = 0;
-int hearts = 5;
-float speedTimer = 10.0f;
-
-float invincibilityTimer = 10.0f; // Invincible for 10 seconds
-float originalSpeed = speed;  // Save the original game speed
-float speedRestoreTime = 0.0f; // Track when to restore the speed
-
-void checkCollisionWithObstacle(Player& player, Obstacle& obstacle, int& hearts) {
-	// Get the current time
-	float currentTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-
-	// Check if the player is invincible or if the obstacle recently hit the player
-	if (player.invincible || obstacle.hitPlayer || hearts == 0 || gameState == 2) {
-		return; // No collision if invincible or obstacle hitPlayer is active
-	}
-
-	// Define hitboxes for the screw head and body
-	float headLeft = obstacle.x;
-	float headRight = obstacle.x + obstacle.width * 0.2f;
-	float headTop = obstacle.y + obstacle.height * 0.5f;
-	float headBottom = obstacle.y - obstacle.height * 0.3f;
-
-	float bodyLeft = obstacle.x - obstacle.width * 1.5f;
-	float bodyRight = obstacle.x;
-	float bodyTop = obstacle.y + obstacle.height * 0.2f;
-	float bodyBottom = obstacle.y + obstacle.height * 0.05f;
-
-	// Check collision for screw head
-	bool headCollision = (player.x < headRight && player.x + player.width > headLeft &&
-		player.y < headTop && player.y + player.height > headBottom);
-
-	// Check collision for screw body
-	bool bodyCollision = (player.x < bodyRight && player.x + player.width > bodyLeft &&
-		player.y < bodyTop && player.y + player.height > bodyBottom);
-
-	// If either part collides, it's considered a hit
-	if (headCollision || bodyCollision) {
-		hearts--; // Reduce hearts
-		playCollisionSound(); // Play collision sound
-
-		// Mark the obstacle as recently hit and store the timestamp
-		obstacle.hitPlayer = true;
-		obstacle.hitTime = currentTime;
-
-		speed = 0.0f;
-		speedRestoreTime = currentTime + 1.0f;  // Set the time to restore speed
-
-		collectableTimer -= 1.0f;
-		obstacleTimer -= 1.0f;
-		powerUpTimer -= 1.0f;
-
-
-		// Push the player back to the start of the obstacle
-		player.x = bodyLeft - 0.1f;
-		// Start the animation to move the obstacle back
-
-	}
-}
-
-
-
-
-void checkCollisionWithCollectable(Player& player, Collectable& collectable, int& score, bool& shouldRemove) {
-	// Check if the player's bounding box overlaps with the collectable (treat it as a circular area)
-	float dx = (player.x + player.width * 0.5f) - collectable.x; // Center x-axis
-	float dy = (player.y + player.height * 0.5f) - collectable.y; // Center y-axis
-	float distance = sqrt(dx * dx + dy * dy); // Euclidean distance
-
-	if (distance < player.width * 0.5f + collectable.radius) {
-		// Collision detected
-		score += 10000; // Increase score
-		shouldRemove = true; // Mark collectable for removal
-	}
-}
-
-
-void checkCollisionWithSpeedPowerUp(Player& player, PowerUp& powerup, float& speed, float& speedTimerStart, bool& shouldRemove) {
-	if (powerup.isSpeedPowerUp) {
-		// Check bounding box overlap with player
-		if (player.x < powerup.x + powerup.size && player.x + player.width > powerup.x &&
-			player.y < powerup.y + powerup.size && player.y + player.height > powerup.y) {
-			// Collision detected
-			speed *= 0.5f; // Cut speed by half
-			speedTimerStart = glutGet(GLUT_ELAPSED_TIME) / 1000.0f; // Set timer for 15 seconds
-
-			shouldRemove = true; // Mark power-up for removal
-		}
-	}
-}
-
-
-
-void checkCollisionWithInvincibilityPowerUp(Player& player, PowerUp& powerup, bool& invincible, float& invincibilityTimerStart, bool& shouldRemove) {
-	if (!powerup.isSpeedPowerUp) {
-		// Check bounding box overlap with player
-		if (player.x < powerup.x + powerup.size && player.x + player.width > powerup.x &&
-			player.y < powerup.y + powerup.size && player.y + player.height > powerup.y) {
-			// Collision detected
-			invincible = true; // Set invincible flag
-			invincibilityTimerStart = glutGet(GLUT_ELAPSED_TIME) / 1000.0f; // Start the timer
-			shouldRemove = true; // Mark power-up for removal
-		}
-	}
-}
-
-
-
-
-
-
-float speedTimerStart = 0.0f;         // Store the time when the speed power-up starts
-float invincibilityTimerStart = 0.0f; // Store the time when the invincibility power-up starts
-
-
-void updateTimer() {
-	// Get the current time in milliseconds since the program started
-	float currentTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;  // Convert to seconds
-
-	// Check if 1 second has passed since the last update
-	if (currentTime - lastUpdateTime >= 1.0f) {
-		if (gameTime > 0) {
-			gameTime--;  // Decrement the game time by 1 second
-		}
-		// Increment the score
-
-	  // Check if it's time to increase the speed
-		if (gameTime % speedIncreaseInterval == 0 && gameTime != lastSpeedIncreaseTime) {
-			speed += 0.005f;  // Increase the speed
-			originalSpeed += 0.005f;
-			lastSpeedIncreaseTime = gameTime;  // Update the last time speed was increased
-		}
-
-		lastUpdateTime = currentTime;  // Reset the last update time to the current time
-	}
-
-	if (hearts <= 0) {
-		gameState = 1;  // You Lose
-	}
-
-	// Check if player wins (time is 0)
-	if (gameTime == 0) {
-		gameState = 2;  // You Win
-	}
-
-
-	// Handle the real-time invincibility power-up timer
-	if (player.invincible) {
-		if (currentTime - invincibilityTimerStart >= 10.0f) { // Check if 10 seconds have passed
-			player.invincible = false;  // Remove invincibility
-		}
-	}
-
-	// Collision detection for each obstacle
-	for (auto& obstacle : obstacles) {
-		checkCollisionWithObstacle(player, obstacle, hearts);
-	}
-
-	// Collision detection for each collectable
-	for (auto& collectable : collectables) {
-		bool shouldRemove = false;
-		checkCollisionWithCollectable(player, collectable, gameScore, shouldRemove);
-	}
-
-	// Collision detection for each power-up
-	for (auto& powerup : powerups) {
-		bool shouldRemove = false;
-		checkCollisionWithSpeedPowerUp(player, powerup, speed, speedTimerStart, shouldRemove);
-		checkCollisionWithInvincibilityPowerUp(player, powerup, player.invincible, invincibilityTimerStart, shouldRemove);
-	}
+	timeText.setNumber(hudFont, "Time: %d", timeLeft);
+	drawText(timeText, 2.8f, 0.85f);  // Adjusted position for visibility
 }
 
-
-
-
-
-
-
 bool backgroundPlaying = false;
 bool youDiedPlayed = false;
 bool youWinPlayed = false;
 
 void display() {
+	if (!hudFont.built()) { // Read back through the frame buffer, so before this frame is drawn
+		hudFont.build(GLUT_BITMAP_HELVETICA_18);
+		bannerFont.build(GLUT_BITMAP_TIMES_ROMAN_24);
+	}
 	glClear(GL_COLOR_BUFFER_BIT);
+	updateFxTweens();
+	batch.startFrame();
+	if (obstacleSprites.needsRecording()) {
+		recordSprites();
+	}
 	drawBoundariesAndDecorations();
 
-	if (gameState == 0) { // Game is still playing
+	if (world.gameState == 0) { // Game is still playing
 		// Draw player
 		// Play background music if not already playing
 		if (!backgroundPlaying) {
 			playBackgroundMusic();
 			backgroundPlaying = true;
 		}
-		player.draw();
+		world.player.draw();
+		batch.flush(); // Under the entities
 
 		// Draw all obstacles
-		for (auto& obs : obstacles) {
-			obs.draw();
+		const ObstacleStore& obs = world.obstacles;
+		for (size_t i = 0; i < obs.count(); i++) {
+			size_t s = obs.slot(i);
+			obstacleSprites.add(obs.x[s], obs.y[s], obs.width[s], obs.height[s]);
 		}
-
-		// Draw all collectables
-		for (auto& col : collectables) {
-			col.draw();
+		obstacleSprites.flush();
+
+		// Draw all collectables, spinning around the Y-axis one turn per 6 seconds
+		const CollectableStore& col = world.collectables;
+		float spin = cosf(collectableSpin * 0.017453293f); // Seen edge-on, the spin only narrows the coin
+		for (size_t i = 0; i < col.count(); i++) {
+			size_t s = col.slot(i);
+			float scale = col.radius[s] / COIN_MESH_RADIUS;
+			coinSprites.add(col.x[s], col.y[s], spin * scale, scale);
+			coinSlotSprites.add(col.x[s], col.y[s], spin * scale, scale);
+			drawCollectableOutline(col.x[s], col.y[s], col.radius[s]);
 		}
+		coinSprites.flush();
+		batch.flush(); // Outlines between the faces and the slots
+		coinSlotSprites.flush();
 
 		// Draw all power-ups
-		for (auto& pwr : powerups) {
-			pwr.draw();
+		const PowerUpStore& pwr = world.powerups;
+		for (size_t i = 0; i < pwr.count(); i++) {
+			size_t s = pwr.slot(i);
+			float scale = pwr.size[s] / POWERUP_MESH_SIZE;
+			InstancedRenderer& sprites = pwr.isSpeedPowerUp(i) ? lightningSprites : pillSprites;
+			sprites.add(pwr.x[s], pwr.y[s] + powerUpBob, scale, scale);
 		}
+		lightningSprites.flush();
+		pillSprites.flush();
 
-		player.update();
+		drawParticles();
 
 		// Draw health (hearts), score, and time
-		drawHearts(hearts);
-		drawScoreAndTime(gameScore, gameTime);  // Display score and time
-	}
-	else if (gameState == 1) { // You lose (YOU DIED)
-		glColor3f(0.7, 0.0, 0.0); // Dark red color
-		glRasterPos2f(1.5f, 0.5f);
-		int finalScore = gameScore;
-		char text[50] = "YOU DIED";
-		for (const char* c = text; *c != '\0'; ++c) {
-			glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, *c);
-
+		for (int i = 0; i < world.hearts; ++i) {
+			heartSprites.add(0.11f * i, 0.0f); // Increased spacing between hearts
 		}
+		heartSprites.flush();
+		drawScoreAndTime(world.gameScore, world.gameTime);  // Display score and time
+	}
+	else if (world.gameState == 1) { // You lose (YOU DIED)
+		batch.color(0.7, 0.0, 0.0); // Dark red color
+		bannerText.set(bannerFont, "YOU DIED");
+		bannerText.draw(batch, 1.5f, 0.5f);
+		int finalScore = world.gameScore;
 		if (backgroundPlaying) {
 			stopBackgroundMusic();
 			backgroundPlaying = false;
@@ -1140,24 +820,17 @@ void display() {
 			youDiedPlayed = true;
 		}
 
-		char scoreStr[50];
-		sprintf(scoreStr, "Score: %d", finalScore);
-		drawText(scoreStr, 1.5f, 0.85f);
+		scoreText.setNumber(hudFont, "Score: %d", finalScore);
+		drawText(scoreText, 1.5f, 0.85f);
 
 	}
-	else if (gameState == 2) { // You win
-		glColor3f(0.1, 0.4, 0.7); // Dark red color
-		glRasterPos2f(1.5f, 0.5f);
-		int finalScore = gameScore;
-		char text[50] = "YOU WIN";
-		for (const char* c = text; *c != '\0'; ++c) {
-			glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, *c);
-
-
-		} // Centered "You Win" message
-		char scoreStr[50];
-		sprintf(scoreStr, "Score: %d", finalScore);
-		drawText(scoreStr, 1.5f, 0.85f);
+	else if (world.gameState == 2) { // You win
+		batch.color(0.1, 0.4, 0.7); // Dark red color
+		bannerText.set(bannerFont, "YOU WIN"); // Centered "You Win" message
+		bannerText.draw(batch, 1.5f, 0.5f);
+		int finalScore = world.gameScore;
+		scoreText.setNumber(hudFont, "Score: %d", finalScore);
+		drawText(scoreText, 1.5f, 0.85f);
 		if (backgroundPlaying) {
 			stopBackgroundMusic();
 			backgroundPlaying = false;
@@ -1171,6 +844,7 @@ void display() {
 
 	}
 
+	batch.flush(); // The text with whatever else is left, in one draw
 	glutSwapBuffers();
 }
 
@@ -1183,81 +857,106 @@ void init() {
 	glOrtho(0.0, 3.0, 0.0, 1.0, -1.0, 1.0); // Set the orthographic projection
 }
 
-void update(int value) {
-	player.update(); // Update the player state (jumping, ducking)
+// Single frame callback: run as many fixed steps as real time allows, then render once
+void frame(int) {
+	simClock.sample(glutGet(GLUT_ELAPSED_TIME) / 1000.0);
 
-	// Redraw the scene
-	glutPostRedisplay();
-
-	// Call update again after 16 ms (~60 frames per second)
-	glutTimerFunc(16, update, 0);
-}
+	while (simClock.takeStep()) {
+		unsigned char press = autoplay ? autoplayer.poll(world) : AUTOPLAY_WAIT;
+		if (press != AUTOPLAY_WAIT) {
+			recording.record(world.tick, press);
+			world.applyInput(press);
+		}
+		world.step();
+		history.record(world);
+
+		if (!recordingSaved) {
+			recordingHash = foldStateHash(recordingHash, world.stateHash());
+			if (world.gameState != 0) {
+				recording.ticks = world.tick;
+				recording.finalHash = recordingHashValid ? recordingHash : 0;
+				recording.save(REPLAY_PATH);
+				recordingSaved = true;
+			}
+		}
 
-void updateGameObjects() {
+		// Audio and particles react to this step's contacts
+		for (const Contact& c : world.contacts) {
+			if (c.type == CONTACT_OBSTACLE) {
+				playCollisionSound();
+			}
+		}
+		emitContactParticles();
+		particles.update(SIM_STEP);
+	}
 
-	float currentTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+	glutPostRedisplay();  // Request a redraw of the screen
 
-	if (speed == 0.0f && currentTime >= speedRestoreTime) {
-		speed = originalSpeed;  // Restore the speed
-	}
+	glutTimerFunc(16, frame, 0);  // Set up the next frame callback (16 ms for ~60 FPS)
+}
 
-	for (auto& obs : obstacles) {
-		if (!obs.isAnimating)
-			obs.move(speed); // Regular movement
 
-		obs.updateHitStatus(currentTime); // Check and reset hitPlayer flag
+// Step back in time and play on from there; inputs after that point are forgotten
+void rewind() {
+	if (world.tick < REWIND_TICKS || !history.rewind(world, world.tick - REWIND_TICKS)) {
+		return; // Not enough history yet
 	}
-	// Move all power-ups
-	for (auto& pwr : powerups) {
-		pwr.move(speed);
-	}
-
-	// Move all collectables
-	for (auto& col : collectables) {
-		col.move(speed);
+	while (!recording.events.empty() && recording.events.back().tick >= world.tick) {
+		recording.events.pop_back();
 	}
-
-	// Move all obstacles
-
-
-	// Remove collided collectables
-	collectables.erase(std::remove_if(collectables.begin(), collectables.end(), [&](Collectable& col) {
-		bool shouldRemove = false;
-		checkCollisionWithCollectable(player, col, gameScore, shouldRemove);
-		return shouldRemove;  // If collision, remove this collectable
-		}), collectables.end());
-
-	// Remove collided power-ups
-	powerups.erase(std::remove_if(powerups.begin(), powerups.end(), [&](PowerUp& pwr) {
-		bool shouldRemove = false;
-		checkCollisionWithSpeedPowerUp(player, pwr, speed, speedTimerStart, shouldRemove);
-		checkCollisionWithInvincibilityPowerUp(player, pwr, player.invincible, invincibilityTimerStart, shouldRemove);
-		return shouldRemove;  // If collision, remove this power-up
-		}), powerups.end());
-
-	updateTimers(0.016f); // Call timer for spawning logic
+	recordingHashValid = false;
 }
 
-
-
-
-void timer(int) {
-	updateGameObjects();  // Update the positions of all objects
-	updateTimer();
-
-	glutPostRedisplay();  // Request a redraw of the screen
-
-	glutTimerFunc(16, timer, 0);  // Set up the next timer callback (16 ms for ~60 FPS)
+// Clock controls; the simulation itself always advances in fixed steps
+void handleKeypress(unsigned char key, int x, int y) {
+	switch (key) {
+	case 'p': case 'P':
+		simClock.paused = !simClock.paused;
+		break;
+	case '+': case '=':
+		simClock.scale = std::min(simClock.scale * 2.0f, 128.0f);
+		break;
+	case '-': case '_':
+		simClock.scale = std::max(simClock.scale * 0.5f, 0.125f);
+		break;
+	case 'f': case 'F':
+		simClock.fastForward = !simClock.fastForward;
+		break;
+	case 'a': case 'A':
+		autoplay = !autoplay;
+		break;
+	case 'x': case 'X': // Particle stress test: top the pool up to 100k long-lived particles
+		if (particles.count() < PARTICLE_STRESS_COUNT) {
+			particles.emit(1.5f, 0.5f, PARTICLE_STRESS_COUNT - particles.count(), 0.6f, 20.0f, particleColor(255, 255, 255));
+		}
+		break;
+	default:
+		break;
+	}
 }
 
-
 void handleSpecialKeypress(int key, int x, int y) {
 	switch (key) {
 	case GLUT_KEY_UP: // Up arrow key
-		player.jump(); // Call the jump method when up arrow is pressed
+		recording.record(world.tick, INPUT_JUMP);
+		world.applyInput(INPUT_JUMP); // Jump when up arrow is pressed
 		break;
 	case GLUT_KEY_DOWN: // Down arrow key
-		player.duck(); // Call the duck method when down arrow is pressed
+		recording.record(world.tick, INPUT_DUCK);
+		world.applyInput(INPUT_DUCK); // Duck when down arrow is pressed
+		break;
+	case GLUT_KEY_F6:
+		rewind();
+		break;
+	case GLUT_KEY_F5:
+		saveSnapshotFile(world, QUICKSAVE_PATH);
+		break;
+	case GLUT_KEY_F9:
+		if (loadSnapshotFile(world, QUICKSAVE_PATH)) {
+			recordingSaved = true; // The recording no longer describes this run
+			history.clear();       // Nor does the rollback history; F6 must not return to the old timeline
+			history.record(world);
+		}
 		break;
 	default:
 		break;
@@ -1268,7 +967,19 @@ void handleSpecialKeypress(int key, int x, int y) {
 int main(int argc, char** argv) {
 
 
-	srand(static_cast<unsigned int>(time(0)));
+	recording.seed = static_cast<uint64_t>(time(0)); // A different run every launch
+	recording.dt = SIM_STEP;
+	world.rng.seed(recording.seed);
+	world.restartSpawns();
+	world.patterns.startWorker(); // Generate spawn layouts ahead, off the frame loop
+	startFxTweens();
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--resume") == 0 && loadSnapshotFile(world, QUICKSAVE_PATH)) {
+			recordingSaved = true; // Only fresh games are recorded
+			history.clear();
+			history.record(world);
+		}
+	}
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
 	glutInitWindowSize(1200, 800);
@@ -1281,10 +992,11 @@ int main(int argc, char** argv) {
 	glutDisplayFunc(display);
 	// Set the special keypress handler (for arrow keys)
 	glutSpecialFunc(handleSpecialKeypress);
+	glutKeyboardFunc(handleKeypress);
 
-	// Start the update loop
-	glutTimerFunc(16, update, 0);
-	glutTimerFunc(16, timer, 0);
+	// Start the frame loop
+	history.record(world); // The starting state, so the first second can be rewound too
+	glutTimerFunc(16, frame, 0);
 	glutMainLoop();
 	soundThread.join();
 	cleanupOpenAL();
@@ -0,0 +1,101 @@
+#include "ParticlePool.h"
+
+#include <cmath>
+
+// SSE2 is part of every x86-64 target and of 32-bit builds with /arch:SSE2 or
+// -msse2, so it is chosen at compile time; anything else takes the scalar loops
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+ParticlePool::ParticlePool(size_t capacity)
+	: position(capacity * 2), velocity(capacity * 2), life(capacity), color(capacity),
+	rng(0x9e3779b97f4a7c15ULL, 0x5851f42d4c957f2dULL) {
+}
+
+size_t ParticlePool::emit(float x, float y, size_t count, float speed, float lifetime, uint32_t rgba) {
+	size_t room = capacity() - live;
+	if (count > room) {
+		dropped += count - room;
+		count = room;
+	}
+	for (size_t n = 0; n < count; n++, live++) {
+		float angle = rng.range(0.0f, 6.2831853f);
+		float s = speed * rng.range(0.3f, 1.0f);
+		position[2 * live] = x;
+		position[2 * live + 1] = y;
+		velocity[2 * live] = s * cosf(angle);
+		velocity[2 * live + 1] = s * sinf(angle);
+		life[live] = lifetime * rng.range(0.5f, 1.0f);
+		color[live] = rgba;
+	}
+	return count;
+}
+
+void ParticlePool::update(float dt) {
+	integrate(dt);
+	removeDead();
+}
+
+// Position by the old velocity, then gravity into the velocity, then age
+void ParticlePool::integrate(float dt) {
+	float* p = position.data();
+	float* v = velocity.data();
+	float* l = life.data();
+	size_t floats = live * 2;
+	float fall = gravity * dt;
+
+	size_t i = 0;
+#if defined(PARTICLES_SSE2)
+	const __m128 step = _mm_set1_ps(dt);
+	const __m128 fallY = _mm_setr_ps(0.0f, fall, 0.0f, fall); // Two particles per register
+	for (; i + 4 <= floats; i += 4) {
+		__m128 vel = _mm_loadu_ps(v + i);
+		_mm_storeu_ps(p + i, _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(vel, step)));
+		_mm_storeu_ps(v + i, _mm_add_ps(vel, fallY));
+	}
+#endif
+	for (; i < floats; i += 2) {
+		p[i] += v[i] * dt;
+		p[i + 1] += v[i + 1] * dt;
+		v[i + 1] += fall;
+	}
+
+	size_t j = 0;
+#if defined(PARTICLES_SSE2)
+	for (; j + 4 <= live; j += 4) {
+		_mm_storeu_ps(l + j, _mm_sub_ps(_mm_loadu_ps(l + j), step));
+	}
+#endif
+	for (; j < live; j++) {
+		l[j] -= dt;
+	}
+}
+
+// Swap each dead particle with the last live one. Runs of four survivors are
+// skipped with one compare, so a frame with few deaths costs little more than a scan.
+void ParticlePool::removeDead() {
+	const float* l = life.data();
+	size_t i = 0;
+	while (i < live) {
+#if defined(PARTICLES_SSE2)
+		if (i + 4 <= live && _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(l + i), _mm_setzero_ps())) == 0) {
+			i += 4;
+			continue;
+		}
+#endif
+		if (life[i] > 0.0f) {
+			i++;
+			continue;
+		}
+		size_t last = --live;
+		position[2 * i] = position[2 * last];
+		position[2 * i + 1] = position[2 * last + 1];
+		velocity[2 * i] = velocity[2 * last];
+		velocity[2 * i + 1] = velocity[2 * last + 1];
+		life[i] = life[last];
+		color[i] = color[last];
+	}
+}
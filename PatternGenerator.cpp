@@ -0,0 +1,416 @@
+#include "PatternGenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "EntityStore.h"
+
+
+// Mirrors of the spawn code in GameWorld and the movement in Player::update
+static const float SPAWN_X = 3.0f;
+static const float PLAYER_X = 0.7f;
+static const float PLAYER_WIDTH = 0.1f;
+static const float PLAYER_HEIGHT = 0.1f;
+static const float DUCK_HEIGHT = 0.05f;
+static const float GROUND_Y = 0.05f;
+static const float JUMP_RISE = 0.75f;  // Seconds up, and again down
+static const float JUMP_TIME = 1.5f;
+static const float JUMP_HEIGHT = 0.3f;
+static const float DUCK_TIME = 0.5f;
+static const float PLAN_STEP = 0.016f; // Resolution of the planner's trajectory checks
+
+
+// When one hitbox of an obstacle overlaps the player's x range, in seconds from
+// the chunk's first spawn, and how far it reaches vertically
+struct PartWindow {
+	float enter, exit;
+	float bottom, top;
+	bool standClear; // A standing player passes under or over it
+};
+
+struct ObstacleTrack {
+	PartWindow part[2]; // Head, body
+	float enter, exit;
+	bool standClear, duckClear;
+};
+
+static bool overlapsVertically(float playerBottom, float playerHeight, const PartWindow& p) {
+	return playerBottom < p.top && playerBottom + playerHeight > p.bottom;
+}
+
+static ObstacleTrack trackObstacle(const PatternItem& o, float spawnTime, float speed) {
+	// Same boxes as ObstacleStore::spawn: head [x, x + 0.2w] x [y - 0.3h, y + 0.5h],
+	// body [x - 1.5w, x] x [y + 0.05h, y + 0.2h]
+	float left[2] = { 0.0f, -o.width * 1.5f };
+	float right[2] = { o.width * 0.2f, 0.0f };
+	float bottom[2] = { o.y - o.height * 0.3f, o.y + o.height * 0.05f };
+	float top[2] = { o.y + o.height * 0.5f, o.y + o.height * 0.2f };
+
+	ObstacleTrack t;
+	bool duck = true;
+	for (int p = 0; p < 2; p++) {
+		PartWindow& w = t.part[p];
+		w.enter = spawnTime + (SPAWN_X + left[p] - PLAYER_X - PLAYER_WIDTH) / speed;
+		w.exit = spawnTime + (SPAWN_X + right[p] - PLAYER_X) / speed;
+		w.bottom = bottom[p];
+		w.top = top[p];
+		w.standClear = !overlapsVertically(GROUND_Y, PLAYER_HEIGHT, w);
+		duck = duck && !overlapsVertically(GROUND_Y, DUCK_HEIGHT, w);
+	}
+	t.enter = std::min(t.part[0].enter, t.part[1].enter);
+	t.exit = std::max(t.part[0].exit, t.part[1].exit);
+	t.standClear = t.part[0].standClear && t.part[1].standClear;
+	t.duckClear = duck && t.exit - t.enter <= DUCK_TIME; // One duck; a re-press leaves a tick at full height
+	return t;
+}
+
+static float jumpBottom(float elapsed) {
+	float progress = (elapsed <= JUMP_RISE) ? elapsed / JUMP_RISE : (JUMP_TIME - elapsed) / JUMP_RISE;
+	return GROUND_Y + progress * JUMP_HEIGHT;
+}
+
+// Does a jump starting at s get past this obstacle? Parts of an upcoming obstacle
+// that pass outside the jump must be cleared standing; earlier obstacles were
+// already planned for up to the jump.
+static bool jumpClears(const ObstacleTrack& t, float s, bool upcoming) {
+	for (int p = 0; p < 2; p++) {
+		const PartWindow& w = t.part[p];
+		float lo = std::max(w.enter, s);
+		float hi = std::min(w.exit, s + JUMP_TIME);
+		for (float at = lo; at < hi; at += PLAN_STEP) {
+			if (overlapsVertically(jumpBottom(at - s), PLAYER_HEIGHT, w)) {
+				return false;
+			}
+		}
+		if (lo < hi && overlapsVertically(jumpBottom(hi - s), PLAYER_HEIGHT, w)) {
+			return false;
+		}
+		bool outside = w.enter < s || w.exit > s + JUMP_TIME;
+		if (upcoming && outside && !w.standClear) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Does a jump from s, aimed at obstacle i, get past everything it meets?
+static bool jumpFrom(const ObstacleTrack* tracks, int count, int i, float s) {
+	for (int j = 0; j < count; j++) {
+		const ObstacleTrack& t = tracks[j];
+		if (j > i && t.enter >= s + JUMP_TIME) {
+			break; // Sorted by entry: this and everything after is planned once the jump lands
+		}
+		bool during = t.exit > s && t.enter < s + JUMP_TIME;
+		if ((j >= i || during) && !jumpClears(t, s, j >= i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Is there a sequence of stand / duck / jump choices that gets past every obstacle?
+// Forward pass over the obstacles sorted by entry: landed[i] is the earliest the
+// player can be back on the ground with everything before obstacle i behind it.
+// Landing earlier never leaves fewer choices, so that one time per obstacle is enough.
+static bool passable(const ObstacleTrack* tracks, int count) {
+	const float never = std::numeric_limits<float>::infinity();
+	float landed[PATTERN_TAIL + PATTERN_CHUNK + 1];
+	std::fill(landed, landed + count + 1, never);
+	landed[0] = -never;
+
+	for (int i = 0; i < count; i++) {
+		if (landed[i] == never) {
+			continue;
+		}
+		const ObstacleTrack& t = tracks[i];
+		if (t.standClear || t.duckClear) {
+			landed[i + 1] = std::min(landed[i + 1], landed[i]);
+		}
+		int lastNext = -1;
+		for (float s = std::max(landed[i], t.enter - JUMP_TIME); s <= t.exit; s += 2.0f * PLAN_STEP) {
+			int next = i + 1;
+			while (next < count && tracks[next].enter < s + JUMP_TIME) {
+				next++; // Obstacles this jump has to clear as well
+			}
+			if (next == lastNext) {
+				continue; // An earlier jump already lands in front of the same obstacle
+			}
+			if (jumpFrom(tracks, count, i, s)) {
+				landed[next] = std::min(landed[next], s + JUMP_TIME);
+				lastNext = next;
+			}
+		}
+	}
+	return landed[count] != never;
+}
+
+// Validate the newest obstacle against those it can interact with. Once the
+// player has had a full jump's time on the ground between two obstacles, no
+// plan on one side constrains the other, so earlier (validated) ones are skipped.
+static bool survivable(const ObstacleTrack* tracks, int count) {
+	ObstacleTrack sorted[PATTERN_TAIL + PATTERN_CHUNK];
+	std::copy(tracks, tracks + count, sorted);
+	std::sort(sorted, sorted + count, [](const ObstacleTrack& a, const ObstacleTrack& b) { return a.enter < b.enter; });
+
+	int from = 0;
+	float lastExit = -std::numeric_limits<float>::infinity();
+	for (int i = 0; i < count; i++) {
+		if (sorted[i].enter - lastExit >= JUMP_TIME) {
+			from = i;
+		}
+		lastExit = std::max(lastExit, sorted[i].exit);
+	}
+	return passable(sorted + from, count - from);
+}
+
+
+static PatternItem rollObstacle(Random& rng) {
+	PatternItem o;
+	o.width = rng.range(0.05f, 0.15f);
+	o.height = rng.range(0.05f, 0.15f);
+	o.y = rng.range(0.1f, 0.3f);
+	o.flags = 0;
+	return o;
+}
+
+void generatePatternChunk(int lane, const PatternState& from, const PatternRules& rules, PatternChunk& out) {
+	PatternState state = from; // out may be where from lives
+	Random rng;
+	rng.state = state.rngState;
+	rng.inc = state.rngInc;
+
+	memset(&out, 0, sizeof(out));
+	out.index = state.chunk;
+	out.lane = static_cast<uint32_t>(lane);
+
+	if (lane == LANE_OBSTACLE) {
+		// The tail spawned at the end of the previous chunk, one interval apart
+		ObstacleTrack tracks[PATTERN_TAIL + PATTERN_CHUNK];
+		int n = 0;
+		for (uint32_t k = 0; k < state.tailCount; k++) {
+			tracks[n++] = trackObstacle(state.tail[k], -rules.obstacleInterval * (state.tailCount - k), rules.scrollSpeed);
+		}
+		int validFrom = 0;
+		for (int i = 0; i < PATTERN_CHUNK; i++) {
+			for (int attempt = 0; ; attempt++) {
+				out.items[i] = rollObstacle(rng);
+				tracks[n] = trackObstacle(out.items[i], rules.obstacleInterval * i, rules.scrollSpeed);
+				if (survivable(tracks + validFrom, n + 1 - validFrom)) {
+					break;
+				}
+				if (attempt >= rules.maxRerolls) {
+					out.forced++;
+					validFrom = n + 1; // Nothing can follow a wall; validate from after it
+					break;
+				}
+				out.rerolls++;
+			}
+			n++;
+		}
+		state.tailCount = PATTERN_TAIL;
+		for (int k = 0; k < PATTERN_TAIL; k++) {
+			state.tail[k] = out.items[PATTERN_CHUNK - PATTERN_TAIL + k];
+		}
+	}
+	else {
+		// Pickups never block the way; same ranges as before they were pre-generated
+		for (int i = 0; i < PATTERN_CHUNK; i++) {
+			PatternItem& p = out.items[i];
+			p.y = rng.range(0.1f, 0.3f);
+			if (lane == LANE_COLLECTABLE) {
+				p.width = 0.05f; // Radius
+			}
+			else {
+				p.width = 0.1f; // Side
+				p.flags = rng.coin() ? POWERUP_SPEED : 0; // Lightning or pill
+			}
+		}
+	}
+
+	state.rngState = rng.state;
+	state.rngInc = rng.inc;
+	state.chunk++;
+	out.next = state;
+}
+
+
+// Single-producer, single-consumer ring; the producer only writes tail, the consumer only head
+template <typename T, size_t N>
+class SpscQueue {
+public:
+	bool full() const {
+		return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == N;
+	}
+
+	bool push(const T& item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == N) {
+			return false;
+		}
+		items[t % N] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = items[h % N];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T items[N];
+	std::atomic<size_t> head{ 0 };
+	std::atomic<size_t> tail{ 0 };
+};
+
+
+// Keeps every lane's queue topped up from a background thread
+class PatternWorker {
+public:
+	PatternWorker(const PatternRules& rules, const PatternChunk current[SPAWN_LANES]) : rules(rules) {
+		for (int lane = 0; lane < SPAWN_LANES; lane++) {
+			state[lane] = current[lane].next;
+		}
+		thread = std::thread(&PatternWorker::run, this);
+	}
+
+	~PatternWorker() {
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+			stopping = true;
+		}
+		wake.notify_one();
+		thread.join();
+	}
+
+	// The lane's next chunk; waits if the worker hasn't finished it yet
+	void take(int lane, PatternChunk& out) {
+		while (!queues[lane].pop(out)) {
+			poke();
+			std::this_thread::yield();
+		}
+		poke(); // There is room again
+	}
+
+private:
+	PatternRules rules;
+	PatternState state[SPAWN_LANES]; // Where each lane's next chunk starts
+	SpscQueue<PatternChunk, 4> queues[SPAWN_LANES];
+	std::mutex sleepLock; // Only guards sleeping; the chunks go through the queues
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread thread;
+
+	bool anyRoom() const {
+		for (int lane = 0; lane < SPAWN_LANES; lane++) {
+			if (!queues[lane].full()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void poke() {
+		{
+			std::lock_guard<std::mutex> guard(sleepLock); // So the wakeup can't fall between the worker's check and its wait
+		}
+		wake.notify_one();
+	}
+
+	void run() {
+		PatternChunk chunk;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(sleepLock);
+				wake.wait(lock, [this] { return stopping || anyRoom(); });
+				if (stopping) {
+					return;
+				}
+			}
+			for (int lane = 0; lane < SPAWN_LANES; lane++) {
+				if (!queues[lane].full()) {
+					generatePatternChunk(lane, state[lane], rules, chunk);
+					state[lane] = chunk.next;
+					queues[lane].push(chunk);
+				}
+			}
+		}
+	}
+};
+
+
+PatternSource::PatternSource() {
+	Random seeds;
+	restart(seeds);
+}
+
+PatternSource::PatternSource(const PatternSource& other) : rules(other.rules) {
+	memcpy(current, other.current, sizeof(current));
+	memcpy(cursor, other.cursor, sizeof(cursor));
+}
+
+PatternSource& PatternSource::operator=(const PatternSource& other) {
+	if (this != &other) {
+		rules = other.rules;
+		memcpy(current, other.current, sizeof(current));
+		memcpy(cursor, other.cursor, sizeof(cursor));
+		resync();
+	}
+	return *this;
+}
+
+PatternSource::~PatternSource() {
+	stopWorker();
+}
+
+void PatternSource::restart(Random& seeds) {
+	memset(current, 0, sizeof(current));
+	for (int lane = 0; lane < SPAWN_LANES; lane++) {
+		Random stream(seeds.next() | (static_cast<uint64_t>(seeds.next()) << 32), static_cast<uint64_t>(lane));
+		current[lane].lane = static_cast<uint32_t>(lane);
+		current[lane].next.rngState = stream.state;
+		current[lane].next.rngInc = stream.inc;
+		cursor[lane] = PATTERN_CHUNK; // The first next() fetches chunk 0
+	}
+	resync();
+}
+
+PatternItem PatternSource::next(int lane) {
+	if (cursor[lane] >= PATTERN_CHUNK) {
+		if (worker) {
+			worker->take(lane, current[lane]);
+		}
+		else {
+			generatePatternChunk(lane, current[lane].next, rules, current[lane]);
+		}
+		cursor[lane] = 0;
+	}
+	return current[lane].items[cursor[lane]++];
+}
+
+void PatternSource::startWorker() {
+	if (!worker) {
+		worker.reset(new PatternWorker(rules, current));
+	}
+}
+
+void PatternSource::stopWorker() {
+	worker.reset();
+}
+
+void PatternSource::resync() {
+	if (worker) {
+		stopWorker(); // Its queues run ahead of a position that no longer exists
+		startWorker();
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Random.h"
+#include "SpawnScheduler.h"
+
+// Spawn layouts (heights, sizes, power-up types) generated ahead of time in
+// fixed-length chunks, one stream of chunks per spawn lane. Obstacle chunks are
+// validated for survivability: a planner tries standing, ducking and jumps with
+// the reach Player::update gives them, and obstacles that would make the chunk
+// impassable at the nominal spacing are re-rolled.
+//
+// A chunk is a pure function of the state it starts from, and carries the state
+// the next chunk starts from. Generation can therefore run on a background
+// worker that fills a lock-free queue per lane, or inline on the calling
+// thread, and both produce the same sequence; batch and replay runs use the
+// inline mode, the windowed game starts the worker. Only the chunk being
+// consumed is world state, so snapshots stay small and copies stay cheap.
+
+const int PATTERN_CHUNK = 16; // Spawns per chunk
+const int PATTERN_TAIL = 2;   // Obstacles carried into the next chunk's validation
+
+// One spawn's layout. Obstacles use all three sizes; collectables use width as
+// the radius; power-ups use width as the side and flags for the type.
+struct PatternItem {
+	float y, width, height;
+	uint32_t flags;
+};
+
+// Where a lane's next chunk starts: its RNG and the obstacles that may still be
+// in front of the player when that chunk's first obstacle arrives
+struct PatternState {
+	uint64_t rngState, rngInc;
+	uint32_t chunk;     // Index of the chunk this state generates
+	uint32_t tailCount;
+	PatternItem tail[PATTERN_TAIL]; // Oldest first
+};
+
+struct PatternChunk {
+	PatternItem items[PATTERN_CHUNK];
+	PatternState next;
+	uint32_t index;
+	uint32_t lane;
+	uint32_t rerolls;    // Obstacles re-rolled by the validation
+	uint32_t forced;     // Obstacles accepted without a passable plan (re-roll budget ran out)
+};
+
+// Inputs to generation; they shape the content, so the worker and the inline
+// path must agree on them
+struct PatternRules {
+	float obstacleInterval = 3.0f; // Nominal seconds between obstacle spawns
+	float scrollSpeed = 0.625f;    // World units per second the validation assumes; slowest is hardest
+	int maxRerolls = 32;           // Per obstacle before it is accepted anyway
+};
+
+void generatePatternChunk(int lane, const PatternState& from, const PatternRules& rules, PatternChunk& out);
+
+
+class PatternWorker;
+
+// The per-world consumer: the chunk each lane is reading and its position in it
+class PatternSource {
+public:
+	PatternRules rules;
+	PatternChunk current[SPAWN_LANES];
+	uint32_t cursor[SPAWN_LANES];
+
+	PatternSource();
+	PatternSource(const PatternSource& other); // Copies the position; the copy generates inline
+	PatternSource& operator=(const PatternSource& other);
+	~PatternSource();
+
+	void restart(Random& seeds); // New streams drawn from seeds; the first chunks are generated inline
+	PatternItem next(int lane);
+
+	void startWorker(); // Generate ahead on a background thread from now on
+	void stopWorker();
+	bool workerRunning() const { return worker != nullptr; }
+	void resync(); // After current/cursor were overwritten (snapshot load): restart generation from them
+
+private:
+	std::unique_ptr<PatternWorker> worker;
+};
@@ -0,0 +1,53 @@
+#include "Random.h"
+
+
+Random::Random(uint64_t seedValue, uint64_t stream) {
+	seed(seedValue, stream);
+}
+
+// Standard PCG32 seeding: the stream picks the increment, then the seed is mixed in
+void Random::seed(uint64_t seedValue, uint64_t stream) {
+	state = 0u;
+	inc = (stream << 1u) | 1u;
+	next();
+	state += seedValue;
+	next();
+}
+
+float Random::nextFloat() {
+	return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); // 24 bits fill a float mantissa exactly
+}
+
+float Random::range(float min, float max) {
+	return min + nextFloat() * (max - min);
+}
+
+uint32_t Random::below(uint32_t bound) {
+	// Reject the low values that would make the modulo uneven
+	uint32_t threshold = (0u - bound) % bound;
+	for (;;) {
+		uint32_t r = next();
+		if (r >= threshold) {
+			return r % bound;
+		}
+	}
+}
+
+// Jump ahead by composing the LCG step with itself delta times, in log2(delta) squarings
+// (Brown, "Random Number Generation with Arbitrary Stride", 1994)
+void Random::advance(uint64_t delta) {
+	uint64_t curMult = 6364136223846793005ULL;
+	uint64_t curPlus = inc;
+	uint64_t accMult = 1u;
+	uint64_t accPlus = 0u;
+	while (delta > 0) {
+		if (delta & 1u) {
+			accMult *= curMult;
+			accPlus = accPlus * curMult + curPlus;
+		}
+		curPlus = (curMult + 1u) * curPlus;
+		curMult *= curMult;
+		delta >>= 1u;
+	}
+	state = accMult * state + accPlus;
+}
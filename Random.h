@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// PCG32 (XSH RR) generator: 64-bit LCG state, 32-bit permuted output. Each
+// GameWorld owns one, so worlds are reproducible from their seed and can run
+// on separate threads without sharing libc's rand() state. Different streams
+// with the same seed give independent sequences, and advance() jumps ahead in
+// O(log n) steps, so a batch can hand each run its own slice of one sequence.
+class Random {
+public:
+	uint64_t state; // Current LCG state
+	uint64_t inc;   // Stream selector, always odd
+
+	explicit Random(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL);
+	void seed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbULL);
+
+	uint32_t next() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + inc;
+		uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+		uint32_t rot = static_cast<uint32_t>(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31u));
+	}
+
+	float nextFloat(); // Uniform in [0, 1)
+	float range(float min, float max); // Uniform in [min, max)
+	uint32_t below(uint32_t bound); // Uniform in [0, bound), unbiased; bound must be nonzero
+	bool coin() { return (next() >> 31) != 0; }
+
+	void advance(uint64_t delta); // Skip delta outputs
+};
@@ -0,0 +1,135 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const char REPLAY_MAGIC[4] = { 'I', 'R', 'P', 'L' };
+static const uint16_t REPLAY_VERSION = 1;
+
+
+// Fixed-width fields are written byte by byte so the file is the same on any host
+static void putBytes(std::vector<unsigned char>& out, uint64_t value, int bytes) {
+	for (int i = 0; i < bytes; i++) {
+		out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+}
+
+static bool getBytes(const std::vector<unsigned char>& in, size_t& pos, uint64_t& value, int bytes) {
+	if (pos + bytes > in.size()) {
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < bytes; i++) {
+		value |= static_cast<uint64_t>(in[pos + i]) << (8 * i);
+	}
+	pos += bytes;
+	return true;
+}
+
+static void putVarint(std::vector<unsigned char>& out, uint32_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+static bool getVarint(const std::vector<unsigned char>& in, size_t& pos, uint32_t& value) {
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (pos >= in.size()) {
+			return false;
+		}
+		unsigned char b = in[pos++];
+		value |= static_cast<uint32_t>(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void Replay::record(uint32_t tick, unsigned char input) {
+	InputEvent e = { tick, input };
+	events.push_back(e);
+}
+
+bool Replay::save(const char* path) const {
+	std::vector<unsigned char> out(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+	uint32_t dtBits;
+	memcpy(&dtBits, &dt, sizeof(dtBits));
+	putBytes(out, REPLAY_VERSION, 2);
+	putBytes(out, seed, 8);
+	putBytes(out, dtBits, 4);
+	putBytes(out, ticks, 4);
+	putBytes(out, finalHash, 8);
+	putBytes(out, events.size(), 4);
+
+	uint32_t lastTick = 0;
+	for (const InputEvent& e : events) {
+		putVarint(out, e.tick - lastTick);
+		out.push_back(e.input);
+		lastTick = e.tick;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+	return (fclose(file) == 0) && ok;
+}
+
+bool Replay::load(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	std::vector<unsigned char> in;
+	unsigned char chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		in.insert(in.end(), chunk, chunk + n);
+	}
+	fclose(file);
+
+	size_t pos = 4;
+	uint64_t version, seedValue, dtBits, tickCount, hash, eventCount;
+	if (in.size() < 4 || memcmp(in.data(), REPLAY_MAGIC, 4) != 0 ||
+		!getBytes(in, pos, version, 2) || version != REPLAY_VERSION ||
+		!getBytes(in, pos, seedValue, 8) || !getBytes(in, pos, dtBits, 4) ||
+		!getBytes(in, pos, tickCount, 4) || !getBytes(in, pos, hash, 8) ||
+		!getBytes(in, pos, eventCount, 4)) {
+		return false;
+	}
+
+	float dtValue;
+	uint32_t dtWord = static_cast<uint32_t>(dtBits);
+	memcpy(&dtValue, &dtWord, sizeof(dtValue));
+	if (!std::isfinite(dtValue) || dtValue <= 0.0f) {
+		return false; // Stepping by it would never reach the tick count or the game's end
+	}
+
+	std::vector<InputEvent> loaded;
+	loaded.reserve(static_cast<size_t>(std::min<uint64_t>(eventCount, in.size() - pos))); // Every event takes at least 2 bytes
+	uint32_t tick = 0;
+	for (uint64_t i = 0; i < eventCount; i++) {
+		uint32_t delta;
+		if (!getVarint(in, pos, delta) || pos >= in.size()) {
+			return false;
+		}
+		tick += delta;
+		InputEvent e = { tick, in[pos++] };
+		loaded.push_back(e);
+	}
+
+	seed = seedValue;
+	dt = dtValue;
+	ticks = static_cast<uint32_t>(tickCount);
+	finalHash = hash;
+	events.swap(loaded);
+	return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Recorded player input for deterministic playback. A replay is the world
+// seed and step size plus every input event tagged with the simulation tick it
+// was applied before; stepping a fresh world with the same seed and feeding it
+// the events at those ticks reproduces the run bit for bit.
+//
+// File layout (little-endian):
+//   "IRPL", u16 version, u64 seed, f32 dt, u32 ticks, u64 final hash, u32 event count,
+//   then per event: the tick delta from the previous event as a LEB128 varint and
+//   one input byte. A 90 s game is a few hundred bytes.
+
+// Input bytes; INPUT_RELEASE marks a key coming back up
+const unsigned char INPUT_JUMP = 1;
+const unsigned char INPUT_DUCK = 2;
+const unsigned char INPUT_RELEASE = 0x80;
+
+struct InputEvent {
+	uint32_t tick;       // Number of steps completed when the input arrived
+	unsigned char input;
+};
+
+class Replay {
+public:
+	uint64_t seed = 0;
+	float dt = 0.0f;         // Step size the run used
+	uint32_t ticks = 0;      // Steps in the recorded run
+	uint64_t finalHash = 0;  // foldStateHash over every step's state hash, 0 if not recorded
+	std::vector<InputEvent> events; // Non-decreasing tick order
+
+	void record(uint32_t tick, unsigned char input);
+	bool save(const char* path) const; // False on I/O failure
+	bool load(const char* path);        // False on I/O failure, a malformed file or a step that is not positive
+};
+
+// Combine one step's state hash into a running hash for the whole run
+inline uint64_t foldStateHash(uint64_t running, uint64_t stateHash) {
+	return (running ^ stateHash) * 1099511628211ULL; // FNV-1a prime
+}
@@ -0,0 +1,181 @@
+#include "Rollback.h"
+
+#include <cstring>
+
+#include "Snapshot.h"
+
+
+RollbackHistory::RollbackHistory(size_t ticks, size_t keyframeInterval)
+	: deltas(ticks > 0 ? ticks : 1), interval(keyframeInterval > 0 ? keyframeInterval : 1) {
+	// Enough keyframes to cover the oldest delta plus the one being built
+	keyframes.resize(deltas.size() / interval + 2);
+}
+
+void RollbackHistory::clear() {
+	deltaHead = 0;
+	deltaCount = 0;
+	keyHead = 0;
+	keyCount = 0;
+}
+
+bool RollbackHistory::has(uint32_t tick) const {
+	return deltaCount > 0 && tick >= oldestTick() && tick <= newestTick();
+}
+
+uint32_t RollbackHistory::oldestTick() const {
+	return deltas[deltaHead].tick;
+}
+
+uint32_t RollbackHistory::newestTick() const {
+	return deltas[(deltaHead + deltaCount - 1) % deltas.size()].tick;
+}
+
+size_t RollbackHistory::bytesUsed() const {
+	size_t bytes = 0;
+	for (size_t i = 0; i < deltaCount; i++) {
+		bytes += deltas[(deltaHead + i) % deltas.size()].runs.size();
+	}
+	for (size_t i = 0; i < keyCount; i++) {
+		bytes += keyframes[(keyHead + i) % keyframes.size()].snapshot.size();
+	}
+	return bytes;
+}
+
+const RollbackHistory::Keyframe* RollbackHistory::findKeyframe(uint32_t tick) const {
+	for (size_t i = 0; i < keyCount; i++) {
+		const Keyframe& k = keyframes[(keyHead + i) % keyframes.size()];
+		if (k.tick == tick) {
+			return &k;
+		}
+	}
+	return nullptr;
+}
+
+
+static void putVarint(std::vector<unsigned char>& out, size_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+static bool getVarint(const unsigned char*& p, const unsigned char* end, size_t& value) {
+	value = 0;
+	for (int shift = 0; p < end && shift < 64; shift += 7) {
+		unsigned char b = *p++;
+		value |= static_cast<size_t>(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// XOR cur against key (bytes past the end of key count as zero) and run-length
+// encode the result as alternating zero runs and literal runs
+static void encodeDelta(const std::vector<unsigned char>& key, const std::vector<unsigned char>& cur, std::vector<unsigned char>& out) {
+	out.clear();
+	putVarint(out, cur.size());
+	size_t i = 0;
+	while (i < cur.size()) {
+		size_t zeroStart = i;
+		while (i < cur.size() && (cur[i] ^ (i < key.size() ? key[i] : 0)) == 0) {
+			i++;
+		}
+		size_t literalStart = i;
+		// A literal run ends at the first pair of unchanged bytes; a lone zero is cheaper inline
+		while (i < cur.size()) {
+			bool same0 = (cur[i] ^ (i < key.size() ? key[i] : 0)) == 0;
+			bool same1 = i + 1 >= cur.size() || (cur[i + 1] ^ (i + 1 < key.size() ? key[i + 1] : 0)) == 0;
+			if (same0 && same1) {
+				break;
+			}
+			i++;
+		}
+		putVarint(out, literalStart - zeroStart);
+		putVarint(out, i - literalStart);
+		for (size_t j = literalStart; j < i; j++) {
+			out.push_back(cur[j] ^ (j < key.size() ? key[j] : 0));
+		}
+	}
+}
+
+static bool decodeDelta(const std::vector<unsigned char>& key, const std::vector<unsigned char>& runs, std::vector<unsigned char>& out) {
+	const unsigned char* p = runs.data();
+	const unsigned char* end = p + runs.size();
+	size_t size;
+	if (!getVarint(p, end, size)) {
+		return false;
+	}
+	out.resize(size);
+	size_t common = size < key.size() ? size : key.size();
+	memcpy(out.data(), key.data(), common);
+	memset(out.data() + common, 0, size - common);
+
+	size_t i = 0;
+	while (p < end) {
+		size_t zeros, literals;
+		if (!getVarint(p, end, zeros) || !getVarint(p, end, literals) ||
+			i + zeros + literals > size || static_cast<size_t>(end - p) < literals) {
+			return false;
+		}
+		i += zeros;
+		for (size_t j = 0; j < literals; j++) {
+			out[i++] ^= *p++;
+		}
+	}
+	return true;
+}
+
+
+void RollbackHistory::record(const GameWorld& world) {
+	if (deltaCount > 0 && world.tick != newestTick() + 1) {
+		clear(); // Out of sequence (a load or a jump); start over
+	}
+	saveSnapshot(world, scratch);
+
+	// Start a new keyframe every interval ticks
+	bool newKey = keyCount == 0 || world.tick - keyframes[(keyHead + keyCount - 1) % keyframes.size()].tick >= interval;
+	if (newKey) {
+		if (keyCount == keyframes.size()) {
+			keyHead = (keyHead + 1) % keyframes.size();
+			keyCount--;
+		}
+		Keyframe& k = keyframes[(keyHead + keyCount) % keyframes.size()];
+		k.tick = world.tick;
+		k.snapshot.assign(scratch.begin(), scratch.end());
+		keyCount++;
+	}
+	const Keyframe& key = keyframes[(keyHead + keyCount - 1) % keyframes.size()];
+
+	if (deltaCount == deltas.size()) {
+		deltaHead = (deltaHead + 1) % deltas.size();
+		deltaCount--;
+	}
+	Delta& d = deltas[(deltaHead + deltaCount) % deltas.size()];
+	d.tick = world.tick;
+	d.keyTick = key.tick;
+	encodeDelta(key.snapshot, scratch, d.runs); // All zero runs for the keyframe's own tick
+	deltaCount++;
+}
+
+bool RollbackHistory::restore(GameWorld& world, uint32_t tick) {
+	if (!has(tick)) {
+		return false;
+	}
+	const Delta& d = deltas[(deltaHead + (tick - oldestTick())) % deltas.size()];
+	const Keyframe* key = findKeyframe(d.keyTick);
+	return key && decodeDelta(key->snapshot, d.runs, scratch) && loadSnapshot(world, scratch.data(), scratch.size());
+}
+
+bool RollbackHistory::rewind(GameWorld& world, uint32_t tick) {
+	if (!restore(world, tick)) {
+		return false;
+	}
+	deltaCount = tick - oldestTick() + 1;
+	while (keyCount > 0 && keyframes[(keyHead + keyCount - 1) % keyframes.size()].tick > tick) {
+		keyCount--;
+	}
+	return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GameWorld.h"
+
+// In-memory history of the last few hundred ticks of world state, for rewinding
+// and re-simulating with different input. Every keyframeInterval ticks a full
+// snapshot (see Snapshot.h) goes into a small keyframe ring; every tick stores
+// its snapshot XORed against the latest keyframe, run-length encoded. Most
+// bytes don't change between nearby ticks, so a delta is mostly zero runs.
+// Keyframes are kept until no stored delta refers to them.
+class RollbackHistory {
+public:
+	explicit RollbackHistory(size_t ticks = 240, size_t keyframeInterval = 30);
+
+	void clear();
+	void record(const GameWorld& world); // After every step; ticks must be consecutive, or the history restarts
+
+	bool has(uint32_t tick) const;
+	uint32_t oldestTick() const;
+	uint32_t newestTick() const;
+	size_t bytesUsed() const; // Encoded bytes across all stored ticks and keyframes
+
+	bool restore(GameWorld& world, uint32_t tick); // World as it was after that tick; false if not stored
+	bool rewind(GameWorld& world, uint32_t tick);  // restore() and forget everything after the tick
+
+private:
+	struct Delta {
+		uint32_t tick;
+		uint32_t keyTick;                 // Keyframe the delta was taken against
+		std::vector<unsigned char> runs;  // (zero run, literal run, literals)* as varints
+	};
+	struct Keyframe {
+		uint32_t tick;
+		std::vector<unsigned char> snapshot;
+	};
+
+	std::vector<Delta> deltas;       // Ring, oldest at deltaHead
+	size_t deltaHead = 0, deltaCount = 0;
+	std::vector<Keyframe> keyframes; // Ring, oldest at keyHead
+	size_t keyHead = 0, keyCount = 0;
+	size_t interval;
+
+	std::vector<unsigned char> scratch; // Current snapshot while recording, decoded one while restoring
+
+	const Keyframe* findKeyframe(uint32_t tick) const;
+};
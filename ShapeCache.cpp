@@ -0,0 +1,22 @@
+#include "ShapeCache.h"
+
+#include <cmath>
+
+
+ShapeCache::ShapeCache()
+	: circle20(arc(0.0f, 2.0f * 3.14159f / 20.0f, 20)),
+	circle50(arc(0.0f, 2.0f * 3.14159f / 50.0f, 50)),
+	leftHalf(arc(3.14159f * 0.5f, 3.14159f / 20.0f, 21)),
+	rightHalf(arc(-3.14159f * 0.5f, 3.14159f / 20.0f, 21)) {
+}
+
+std::vector<float> ShapeCache::arc(float start, float step, int count) {
+	std::vector<float> points;
+	points.reserve(2 * count);
+	for (int i = 0; i < count; i++) {
+		float theta = start + step * float(i);
+		points.push_back(cosf(theta));
+		points.push_back(sinf(theta));
+	}
+	return points;
+}
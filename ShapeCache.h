@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+// Round outlines tessellated once instead of every frame. Each shape is a list
+// of x, y pairs on the unit circle, built with the same angles the draw code
+// used to compute per vertex (including its 3.14159 for pi), so the drawn
+// outlines are unchanged; a draw call only scales and moves the list, e.g.
+// through BatchRenderer::appendShape(). Built when the cache is constructed,
+// so a global cache costs nothing after startup.
+
+class ShapeCache {
+public:
+	std::vector<float> circle20;  // 20 points, counter-clockwise from +x
+	std::vector<float> circle50;  // 50 points, counter-clockwise from +x
+	std::vector<float> leftHalf;  // 21 points from +y through -x to -y
+	std::vector<float> rightHalf; // 21 points from -y through +x to +y
+
+	ShapeCache();
+
+	// count points at angles start, start + step, ... (radians)
+	static std::vector<float> arc(float start, float step, int count);
+};
@@ -0,0 +1,60 @@
+#include "SimClock.h"
+
+#include <chrono>
+
+
+static double wallSeconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+SimClock::SimClock(float fixedStep) : step(fixedStep) {}
+
+void SimClock::reset(double realSeconds) {
+	lastReal = realSeconds;
+	started = true;
+	accumulator = 0.0;
+}
+
+void SimClock::sample(double realSeconds) {
+	if (!started) {
+		reset(realSeconds);
+	}
+	double elapsed = realSeconds - lastReal;
+	lastReal = realSeconds;
+	stepsThisFrame = 0;
+	frameStart = wallSeconds();
+
+	if (paused || fastForward) {
+		accumulator = 0.0; // Fast-forward isn't paced by real time, so nothing is banked
+		return;
+	}
+	accumulator += elapsed * scale;
+
+	// Drop time we can't catch up on (window drag, breakpoint) instead of spiralling;
+	// a higher scale legitimately needs more steps per frame
+	double cap = step * maxCatchUpSteps * (scale > 1.0f ? scale : 1.0f);
+	if (accumulator > cap) {
+		accumulator = cap;
+	}
+}
+
+bool SimClock::takeStep() {
+	if (paused) {
+		return false;
+	}
+	if (fastForward) {
+		// Check the wall clock every few steps; a step is far cheaper than the query
+		if ((stepsThisFrame & 15) == 15 && wallSeconds() - frameStart >= fastForwardBudget) {
+			return false;
+		}
+		stepsThisFrame++;
+		return true;
+	}
+	if (accumulator >= step) {
+		accumulator -= step;
+		stepsThisFrame++;
+		return true;
+	}
+	return false;
+}
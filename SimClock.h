@@ -0,0 +1,30 @@
+#pragma once
+
+// Turns real frame times into fixed simulation steps. The front-end samples
+// real time once per frame; the clock scales it, holds it while paused, and
+// banks it in an accumulator that is paid out one fixed step at a time. Every
+// timed rule reads GameWorld::time, which only advances by those steps, so a
+// game runs the same at any scale. Fast-forward ignores real time and hands
+// out steps until the frame's wall-clock budget is spent.
+class SimClock {
+public:
+	float step;                    // Fixed simulation step in seconds
+	float scale = 1.0f;            // Simulated seconds per real second
+	bool paused = false;
+	bool fastForward = false;      // As many steps as fit in fastForwardBudget each frame
+	double fastForwardBudget = 0.012; // Real seconds per frame spent stepping in fast-forward
+	int maxCatchUpSteps = 8;       // Real time beyond this many (scaled) steps is dropped after a stall
+
+	explicit SimClock(float fixedStep);
+
+	void sample(double realSeconds); // Once per frame, before taking steps
+	bool takeStep();                 // True while another step is due this frame
+	void reset(double realSeconds);  // Forget banked time, e.g. after a long load
+
+private:
+	double lastReal = 0.0;
+	bool started = false;
+	double accumulator = 0.0; // Simulated seconds not yet stepped
+	int stepsThisFrame = 0;
+	double frameStart = 0.0;  // Wall clock at sample(), for the fast-forward budget
+};
@@ -0,0 +1,386 @@
+#include "Snapshot.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+static const char SNAPSHOT_MAGIC[4] = { 'I', 'R', 'S', 'N' };
+
+
+// Every non-entity field, laid out once so it can be copied as a block
+struct WorldScalars {
+	// Player
+	float x, y, width, height, jumpHeight, maxJumpHeight;
+	float duckStartTime, jumpStartTime;
+	uint8_t isJumping, isDucking, invincible, pad0;
+
+	// Clocks and rules
+	float time, stepTravel, stepStartY, stepStartHeight;
+	uint32_t tick;
+	int32_t gameState, hearts, gameTime, gameScore;
+	float lastUpdateTime;
+	float speed, originalSpeed, speedRestoreTime;
+	int32_t speedIncreaseInterval, lastSpeedIncreaseTime;
+	float speedIncrement;
+	float speedTimerStart, invincibilityTimerStart;
+
+	// Spawning
+	float spawnCollectableTime, spawnPowerUpTime, spawnObstacleTime;
+	float spawnOffset, spawnPausedAt;
+	float spawnSeparation[SPAWN_LANES], lastSpawn[SPAWN_LANES];
+	uint32_t spawnSeq;
+	uint8_t spawnPaused, pad1[3];
+	uint64_t rngState, rngInc;
+	uint64_t timerCursor;
+
+	// Store bounds
+	float maxWidth, maxRadius, maxSize;
+	uint32_t pad2;
+};
+
+static void gatherScalars(const GameWorld& w, WorldScalars& s) {
+	memset(&s, 0, sizeof(s)); // Deterministic padding bytes
+	const Player& p = w.player;
+	s.x = p.x; s.y = p.y; s.width = p.width; s.height = p.height;
+	s.jumpHeight = p.jumpHeight; s.maxJumpHeight = p.maxJumpHeight;
+	s.duckStartTime = p.duckStartTime; s.jumpStartTime = p.jumpStartTime;
+	s.isJumping = p.isJumping; s.isDucking = p.isDucking; s.invincible = p.invincible;
+
+	s.time = w.time; s.stepTravel = w.stepTravel; s.stepStartY = w.stepStartY; s.stepStartHeight = w.stepStartHeight;
+	s.tick = w.tick;
+	s.gameState = w.gameState; s.hearts = w.hearts; s.gameTime = w.gameTime; s.gameScore = w.gameScore;
+	s.lastUpdateTime = w.lastUpdateTime;
+	s.speed = w.speed; s.originalSpeed = w.originalSpeed; s.speedRestoreTime = w.speedRestoreTime;
+	s.speedIncreaseInterval = w.speedIncreaseInterval; s.lastSpeedIncreaseTime = w.lastSpeedIncreaseTime;
+	s.speedIncrement = w.speedIncrement;
+	s.speedTimerStart = w.speedTimerStart; s.invincibilityTimerStart = w.invincibilityTimerStart;
+
+	s.spawnCollectableTime = w.spawnCollectableTime; s.spawnPowerUpTime = w.spawnPowerUpTime;
+	s.spawnObstacleTime = w.spawnObstacleTime;
+	s.spawnOffset = w.spawns.offset; s.spawnPausedAt = w.spawns.pausedAt;
+	memcpy(s.spawnSeparation, w.spawns.separation, sizeof(s.spawnSeparation));
+	memcpy(s.lastSpawn, w.spawns.lastSpawn, sizeof(s.lastSpawn));
+	s.spawnSeq = w.spawns.nextSeq; s.spawnPaused = w.spawns.paused;
+	s.rngState = w.rng.state; s.rngInc = w.rng.inc;
+	s.timerCursor = w.timers.now();
+
+	s.maxWidth = w.obstacles.maxWidth; s.maxRadius = w.collectables.maxRadius; s.maxSize = w.powerups.maxSize;
+}
+
+static void applyScalars(const WorldScalars& s, GameWorld& w) {
+	Player& p = w.player;
+	p.x = s.x; p.y = s.y; p.width = s.width; p.height = s.height;
+	p.jumpHeight = s.jumpHeight; p.maxJumpHeight = s.maxJumpHeight;
+	p.duckStartTime = s.duckStartTime; p.jumpStartTime = s.jumpStartTime;
+	p.isJumping = s.isJumping != 0; p.isDucking = s.isDucking != 0; p.invincible = s.invincible != 0;
+
+	w.time = s.time; w.stepTravel = s.stepTravel; w.stepStartY = s.stepStartY; w.stepStartHeight = s.stepStartHeight;
+	w.tick = s.tick;
+	w.gameState = s.gameState; w.hearts = s.hearts; w.gameTime = s.gameTime; w.gameScore = s.gameScore;
+	w.lastUpdateTime = s.lastUpdateTime;
+	w.speed = s.speed; w.originalSpeed = s.originalSpeed; w.speedRestoreTime = s.speedRestoreTime;
+	w.speedIncreaseInterval = s.speedIncreaseInterval; w.lastSpeedIncreaseTime = s.lastSpeedIncreaseTime;
+	w.speedIncrement = s.speedIncrement;
+	w.speedTimerStart = s.speedTimerStart; w.invincibilityTimerStart = s.invincibilityTimerStart;
+
+	w.spawnCollectableTime = s.spawnCollectableTime; w.spawnPowerUpTime = s.spawnPowerUpTime;
+	w.spawnObstacleTime = s.spawnObstacleTime;
+	w.spawns.offset = s.spawnOffset; w.spawns.pausedAt = s.spawnPausedAt;
+	memcpy(w.spawns.separation, s.spawnSeparation, sizeof(s.spawnSeparation));
+	memcpy(w.spawns.lastSpawn, s.lastSpawn, sizeof(s.lastSpawn));
+	w.spawns.nextSeq = s.spawnSeq; w.spawns.paused = s.spawnPaused != 0;
+	w.rng.state = s.rngState; w.rng.inc = s.rngInc;
+	w.timers.reset(s.timerCursor);
+
+	w.obstacles.maxWidth = s.maxWidth; w.collectables.maxRadius = s.maxRadius; w.powerups.maxSize = s.maxSize;
+}
+
+
+// The spawn pattern position: the chunk each lane is reading, whole
+struct PatternBlock {
+	PatternRules rules;
+	uint32_t cursor[SPAWN_LANES];
+	PatternChunk current[SPAWN_LANES];
+};
+// Saved as raw bytes, so there must be no padding for them to be deterministic
+static_assert(sizeof(PatternBlock) == sizeof(PatternRules) + sizeof(uint32_t) * SPAWN_LANES + sizeof(PatternChunk) * SPAWN_LANES,
+	"PatternBlock has padding");
+
+static void gatherPatterns(const GameWorld& w, PatternBlock& b) {
+	b.rules = w.patterns.rules;
+	memcpy(b.cursor, w.patterns.cursor, sizeof(b.cursor));
+	memcpy(b.current, w.patterns.current, sizeof(b.current));
+}
+
+
+// Copy the live part of a column out oldest first: at most two memcpys
+template <typename T>
+static void putColumn(unsigned char*& out, const EntityRing& ring, const std::vector<T>& column) {
+	size_t begin[2], end[2];
+	int n = ring.spans(begin, end);
+	for (int s = 0; s < n; s++) {
+		size_t bytes = (end[s] - begin[s]) * sizeof(T);
+		memcpy(out, column.data() + begin[s], bytes);
+		out += bytes;
+	}
+}
+
+// Fill slots [0, count) of a column; the caller has checked the size
+template <typename T>
+static void getColumn(const unsigned char*& in, std::vector<T>& column, size_t count) {
+	memcpy(column.data(), in, count * sizeof(T));
+	in += count * sizeof(T);
+}
+
+// Bytes per entity over the columns written below
+static const size_t OBSTACLE_BYTES = 11 * sizeof(float) + 1;
+static const size_t COLLECTABLE_BYTES = 3 * sizeof(float) + 1;
+static const size_t POWERUP_BYTES = 3 * sizeof(float) + 1;
+
+// A pending timer as saved; obstacle timers hold a logical index, not a slot
+struct SavedTimer {
+	uint64_t due;
+	float stamp;
+	uint32_t target;
+	uint8_t kind, pad[7];
+};
+
+// A running tween as saved. Values are recomputed by the next evaluate(), so they aren't saved.
+struct SavedTween {
+	float start, invDuration, from, delta;
+	float c1, c2, c3, pingPong, loop;
+	uint32_t target;
+	uint16_t kind, pad;
+};
+
+// A spawn event as saved, in heap order
+struct SavedSpawn {
+	float key;
+	uint32_t seq;
+	uint8_t lane, pad[3];
+};
+
+
+void saveSnapshot(const GameWorld& world, std::vector<unsigned char>& out) {
+	WorldScalars scalars;
+	gatherScalars(world, scalars);
+	uint32_t header[2] = { SNAPSHOT_VERSION, static_cast<uint32_t>(sizeof(WorldScalars)) };
+	std::vector<Timer> timers;
+	world.timers.collect(timers);
+	uint32_t counts[6] = { static_cast<uint32_t>(world.obstacles.count()),
+		static_cast<uint32_t>(world.collectables.count()), static_cast<uint32_t>(world.powerups.count()),
+		static_cast<uint32_t>(timers.size()), static_cast<uint32_t>(world.spawns.events.size()),
+		static_cast<uint32_t>(world.tweens.count()) };
+
+	PatternBlock patterns = {};
+	gatherPatterns(world, patterns);
+
+	size_t fixed = 4 + sizeof(header) + sizeof(scalars) + sizeof(patterns) + sizeof(counts);
+	out.resize(fixed + counts[0] * OBSTACLE_BYTES + counts[1] * COLLECTABLE_BYTES + counts[2] * POWERUP_BYTES +
+		counts[3] * sizeof(SavedTimer) + counts[4] * sizeof(SavedSpawn) + counts[5] * sizeof(SavedTween));
+	unsigned char* at = out.data();
+	memcpy(at, SNAPSHOT_MAGIC, 4);
+	memcpy(at + 4, header, sizeof(header));
+	memcpy(at + 4 + sizeof(header), &scalars, sizeof(scalars));
+	memcpy(at + 4 + sizeof(header) + sizeof(scalars), &patterns, sizeof(patterns));
+	memcpy(at + 4 + sizeof(header) + sizeof(scalars) + sizeof(patterns), counts, sizeof(counts));
+	at += fixed;
+
+	const ObstacleStore& o = world.obstacles;
+	putColumn(at, o.ring, o.x); putColumn(at, o.ring, o.y);
+	putColumn(at, o.ring, o.width); putColumn(at, o.ring, o.height);
+	putColumn(at, o.ring, o.headReach); putColumn(at, o.ring, o.headBottom); putColumn(at, o.ring, o.headTop);
+	putColumn(at, o.ring, o.bodyReach); putColumn(at, o.ring, o.bodyBottom); putColumn(at, o.ring, o.bodyTop);
+	putColumn(at, o.ring, o.hitTime);
+	putColumn(at, o.ring, o.flags);
+
+	const CollectableStore& c = world.collectables;
+	putColumn(at, c.ring, c.x); putColumn(at, c.ring, c.y); putColumn(at, c.ring, c.radius);
+	putColumn(at, c.ring, c.flags);
+
+	const PowerUpStore& p = world.powerups;
+	putColumn(at, p.ring, p.x); putColumn(at, p.ring, p.y); putColumn(at, p.ring, p.size);
+	putColumn(at, p.ring, p.flags);
+
+	for (const Timer& t : timers) {
+		SavedTimer saved;
+		memset(&saved, 0, sizeof(saved));
+		saved.due = t.due;
+		saved.stamp = t.stamp;
+		saved.target = (t.kind == TIMER_OBSTACLE_HIT) ? static_cast<uint32_t>(o.ring.logical(t.target)) : t.target;
+		saved.kind = t.kind;
+		memcpy(at, &saved, sizeof(saved));
+		at += sizeof(saved);
+	}
+
+	for (const SpawnEvent& e : world.spawns.events) {
+		SavedSpawn saved;
+		memset(&saved, 0, sizeof(saved));
+		saved.key = e.key;
+		saved.seq = e.seq;
+		saved.lane = e.lane;
+		memcpy(at, &saved, sizeof(saved));
+		at += sizeof(saved);
+	}
+
+	const TweenSystem& tw = world.tweens;
+	for (size_t i = 0; i < tw.count(); i++) {
+		SavedTween saved;
+		memset(&saved, 0, sizeof(saved));
+		saved.start = tw.start[i]; saved.invDuration = tw.invDuration[i];
+		saved.from = tw.from[i]; saved.delta = tw.delta[i];
+		saved.c1 = tw.c1[i]; saved.c2 = tw.c2[i]; saved.c3 = tw.c3[i];
+		saved.pingPong = tw.pingPong[i]; saved.loop = tw.loop[i];
+		saved.target = tw.target[i];
+		saved.kind = tw.kind[i];
+		memcpy(at, &saved, sizeof(saved));
+		at += sizeof(saved);
+	}
+}
+
+bool loadSnapshot(GameWorld& world, const unsigned char* data, size_t size) {
+	// Validate everything before touching the world
+	uint32_t header[2];
+	uint32_t counts[6];
+	size_t fixed = 4 + sizeof(header) + sizeof(WorldScalars) + sizeof(PatternBlock) + sizeof(counts);
+	if (size < fixed || memcmp(data, SNAPSHOT_MAGIC, 4) != 0) {
+		return false;
+	}
+	memcpy(header, data + 4, sizeof(header));
+	if (header[0] != SNAPSHOT_VERSION || header[1] != sizeof(WorldScalars)) {
+		return false;
+	}
+	PatternBlock patterns;
+	memcpy(&patterns, data + 4 + sizeof(header) + sizeof(WorldScalars), sizeof(patterns));
+	for (int lane = 0; lane < SPAWN_LANES; lane++) {
+		if (patterns.cursor[lane] > PATTERN_CHUNK || patterns.current[lane].lane != static_cast<uint32_t>(lane) ||
+			patterns.current[lane].next.tailCount > PATTERN_TAIL) {
+			return false;
+		}
+	}
+	memcpy(counts, data + 4 + sizeof(header) + sizeof(WorldScalars) + sizeof(PatternBlock), sizeof(counts));
+	if (counts[0] > world.obstacles.ring.capacity() || counts[1] > world.collectables.ring.capacity() ||
+		counts[2] > world.powerups.ring.capacity()) {
+		return false;
+	}
+	if (size != fixed + counts[0] * OBSTACLE_BYTES + counts[1] * COLLECTABLE_BYTES + counts[2] * POWERUP_BYTES +
+		static_cast<size_t>(counts[3]) * sizeof(SavedTimer) + static_cast<size_t>(counts[4]) * sizeof(SavedSpawn) +
+		static_cast<size_t>(counts[5]) * sizeof(SavedTween)) {
+		return false;
+	}
+	const unsigned char* spawnData = data + size - counts[5] * sizeof(SavedTween) - counts[4] * sizeof(SavedSpawn);
+	for (uint32_t i = 0; i < counts[4]; i++) {
+		if (spawnData[i * sizeof(SavedSpawn) + offsetof(SavedSpawn, lane)] >= SPAWN_LANES) {
+			return false; // The scheduler indexes its lane tables with it
+		}
+	}
+	// An obstacle-hit timer's target indexes the columns directly once loaded, so it must name a live obstacle
+	const unsigned char* timerData = spawnData - counts[3] * sizeof(SavedTimer);
+	for (uint32_t i = 0; i < counts[3]; i++) {
+		SavedTimer saved;
+		memcpy(&saved, timerData + i * sizeof(SavedTimer), sizeof(saved));
+		if (saved.kind > TIMER_INVINCIBILITY || (saved.kind == TIMER_OBSTACLE_HIT && saved.target >= counts[0])) {
+			return false;
+		}
+	}
+	const unsigned char* tweenData = data + size - counts[5] * sizeof(SavedTween);
+	for (uint32_t i = 0; i < counts[5]; i++) {
+		SavedTween saved;
+		memcpy(&saved, tweenData + i * sizeof(SavedTween), sizeof(saved));
+		if (saved.kind != TWEEN_PLAYER_Y || !std::isfinite(saved.invDuration) || saved.invDuration == 0.0f) {
+			return false;
+		}
+	}
+
+	WorldScalars scalars;
+	memcpy(&scalars, data + 4 + sizeof(header), sizeof(scalars));
+	applyScalars(scalars, world);
+	world.patterns.rules = patterns.rules;
+	memcpy(world.patterns.cursor, patterns.cursor, sizeof(patterns.cursor));
+	memcpy(world.patterns.current, patterns.current, sizeof(patterns.current));
+	world.patterns.resync();
+
+	const unsigned char* in = data + fixed;
+	ObstacleStore& o = world.obstacles;
+	o.ring.assign(counts[0]);
+	getColumn(in, o.x, counts[0]); getColumn(in, o.y, counts[0]);
+	getColumn(in, o.width, counts[0]); getColumn(in, o.height, counts[0]);
+	getColumn(in, o.headReach, counts[0]); getColumn(in, o.headBottom, counts[0]); getColumn(in, o.headTop, counts[0]);
+	getColumn(in, o.bodyReach, counts[0]); getColumn(in, o.bodyBottom, counts[0]); getColumn(in, o.bodyTop, counts[0]);
+	getColumn(in, o.hitTime, counts[0]);
+	getColumn(in, o.flags, counts[0]);
+
+	CollectableStore& c = world.collectables;
+	c.ring.assign(counts[1]);
+	getColumn(in, c.x, counts[1]); getColumn(in, c.y, counts[1]); getColumn(in, c.radius, counts[1]);
+	getColumn(in, c.flags, counts[1]);
+
+	PowerUpStore& p = world.powerups;
+	p.ring.assign(counts[2]);
+	getColumn(in, p.x, counts[2]); getColumn(in, p.y, counts[2]); getColumn(in, p.size, counts[2]);
+	getColumn(in, p.flags, counts[2]);
+
+	// The rings now start at slot 0, so a saved logical index is the slot
+	for (uint32_t i = 0; i < counts[3]; i++) {
+		SavedTimer saved;
+		memcpy(&saved, in, sizeof(saved));
+		in += sizeof(saved);
+		Timer t = { saved.due, saved.stamp, saved.target, saved.kind };
+		world.timers.schedule(t);
+	}
+
+	world.spawns.events.resize(counts[4]);
+	for (uint32_t i = 0; i < counts[4]; i++) {
+		SavedSpawn saved;
+		memcpy(&saved, in, sizeof(saved));
+		in += sizeof(saved);
+		SpawnEvent e = { saved.key, saved.seq, saved.lane };
+		world.spawns.events[i] = e;
+	}
+
+	TweenSystem& tw = world.tweens;
+	tw.resize(counts[5]);
+	for (uint32_t i = 0; i < counts[5]; i++) {
+		SavedTween saved;
+		memcpy(&saved, in, sizeof(saved));
+		in += sizeof(saved);
+		tw.start[i] = saved.start; tw.invDuration[i] = saved.invDuration;
+		tw.from[i] = saved.from; tw.delta[i] = saved.delta;
+		tw.c1[i] = saved.c1; tw.c2[i] = saved.c2; tw.c3[i] = saved.c3;
+		tw.pingPong[i] = saved.pingPong; tw.loop[i] = saved.loop;
+		tw.kind[i] = saved.kind; tw.target[i] = saved.target;
+		tw.value[i] = saved.from;
+		tw.done[i] = 0;
+	}
+
+	world.contacts.clear(); // They belong to the step before the snapshot was taken
+	return true;
+}
+
+
+bool saveSnapshotFile(const GameWorld& world, const char* path) {
+	std::vector<unsigned char> blob;
+	saveSnapshot(world, blob);
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	bool ok = fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+	return (fclose(file) == 0) && ok;
+}
+
+bool loadSnapshotFile(GameWorld& world, const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	std::vector<unsigned char> blob;
+	unsigned char chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		blob.insert(blob.end(), chunk, chunk + n);
+	}
+	fclose(file);
+	return loadSnapshot(world, blob.data(), blob.size());
+}
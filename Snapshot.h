@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "GameWorld.h"
+
+// Versioned binary snapshot of everything a GameWorld needs to continue
+// exactly where it was: player, clocks, speed, the spawn timeline and
+// patterns, RNG, running tweens, pending effect timers and every live entity.
+// The scalars travel as one fixed-layout block and each entity column as one
+// contiguous run in oldest-first order, so both directions are a handful of
+// memcpys. Restoring re-bases every ring at slot 0.
+//
+// Layout: "IRSN", u32 version, u32 scalar block size, scalar block, pattern
+// block, u32 count per store (obstacles, collectables, power-ups), of pending
+// effect timers, of spawn events and of tweens, then the columns, the timers,
+// the spawn heap and the tweens.
+// Host byte order and float format; meant for the machine that wrote it.
+// The ring statistics (peak, spawned, ...) are diagnostics and not saved.
+
+// 2: player jump/duck start times in seconds instead of half-seconds
+// 3: timer wheel; 4: spawn scheduler; 5: spawn patterns
+// 6: tweens, obstacle move-back columns dropped; 7: unused obstacle move-back count dropped
+const uint32_t SNAPSHOT_VERSION = 7;
+
+void saveSnapshot(const GameWorld& world, std::vector<unsigned char>& out); // Replaces out's contents
+
+// False (and world untouched) if the blob is malformed, from another version,
+// or holds more entities than the world's rings can
+bool loadSnapshot(GameWorld& world, const unsigned char* data, size_t size);
+
+bool saveSnapshotFile(const GameWorld& world, const char* path);
+bool loadSnapshotFile(GameWorld& world, const char* path);
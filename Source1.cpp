@@ -11,6 +11,14 @@
 #include <vector>
 #include <string>
 
+#include "BatchRenderer.h"
+#include "GlyphAtlas.h"
+#include "Random.h"
+#include "Replay.h"
+#include "ShapeCache.h"
+#include "StaticLayer.h"
+#include "TimerWheel.h"
+
 // Global variables for player position, health, score, etc.
 float playerY = 0.0f;  // Player's vertical position
 float jumpTargetY = 0.2f;     // Target Y position for jump (1 step up)
@@ -67,6 +75,15 @@ bool powerUp2Spawned = false;
 bool powerUp2Active = false;
 float oldSpeedMultiplier;
 
+// Power-up expiry; fired from update() instead of being re-checked every frame
+const uint8_t TIMER_POWERUP1_END = 0;
+const uint8_t TIMER_POWERUP2_END = 1;
+TimerWheel powerUpTimers;
+
+BatchRenderer batch;  // Every shape is appended here and drawn in a couple of calls per frame
+const ShapeCache shapes;  // Round outlines, tessellated once at startup
+StaticLayer borderLayer;  // Borders and ground line, recorded on the first frame
+
 
 bool groundCollision = false;
 bool aboveCollision = false;
@@ -234,140 +251,135 @@ void init() {
 
 // Function to draw the player using 4 different primitives
 void drawPlayer() {
-    glPushMatrix();
-    glTranslatef(-0.8f, playerY, 0.0f);  // Player's position
+    batch.push();
+    batch.translate(-0.8f, playerY);  // Player's position
     if (isDucking) {
-        glScalef(1.0f, 0.5f, 1.0f);  // Shrink player vertically (reduce height by 50%)
+        batch.scale(1.0f, 0.5f);  // Shrink player vertically (reduce height by 50%)
     }
 
     // Primitive 1: Body (Quad)
-    glColor3f(0.0f, 1.0f, 0.0f);  // Green color
-    glBegin(GL_QUADS);
-    glVertex2f(-0.05f, -0.05f);
-    glVertex2f(0.05f, -0.05f);
-    glVertex2f(0.05f, 0.1f);  // Taller body
-    glVertex2f(-0.05f, 0.1f);
-    glEnd();
+    batch.color(0.0f, 1.0f, 0.0f);  // Green color
+    batch.begin(GL_QUADS);
+    batch.vertex(-0.05f, -0.05f);
+    batch.vertex(0.05f, -0.05f);
+    batch.vertex(0.05f, 0.1f);  // Taller body
+    batch.vertex(-0.05f, 0.1f);
+    batch.end();
 
     // Primitive 2: Head (Triangle)
-    glColor3f(1.0f, 1.0f, 0.0f);  // Yellow head
-    glBegin(GL_TRIANGLES);
-    glVertex2f(-0.03f, 0.1f);
-    glVertex2f(0.03f, 0.1f);
-    glVertex2f(0.0f, 0.15f);  // Pointy head
-    glEnd();
+    batch.color(1.0f, 1.0f, 0.0f);  // Yellow head
+    batch.begin(GL_TRIANGLES);
+    batch.vertex(-0.03f, 0.1f);
+    batch.vertex(0.03f, 0.1f);
+    batch.vertex(0.0f, 0.15f);  // Pointy head
+    batch.end();
 
     // Primitive 3: Arms (Line Strips)
-    glColor3f(0.0f, 0.0f, 1.0f);  // Blue arms
-    glBegin(GL_LINE_STRIP);
-    glVertex2f(-0.05f, 0.05f);  // Left arm
-    glVertex2f(-0.1f, 0.0f);
-    glEnd();
+    batch.color(0.0f, 0.0f, 1.0f);  // Blue arms
+    batch.begin(GL_LINE_STRIP);
+    batch.vertex(-0.05f, 0.05f);  // Left arm
+    batch.vertex(-0.1f, 0.0f);
+    batch.end();
 
-    glBegin(GL_LINE_STRIP);
-    glVertex2f(0.05f, 0.05f);  // Right arm
-    glVertex2f(0.1f, 0.0f);
-    glEnd();
+    batch.begin(GL_LINE_STRIP);
+    batch.vertex(0.05f, 0.05f);  // Right arm
+    batch.vertex(0.1f, 0.0f);
+    batch.end();
 
     // Primitive 4: Feet (Points)
-    glColor3f(1.0f, 0.0f, 0.0f);  // Red feet
-    glPointSize(5.0f);  // Make points larger
-    glBegin(GL_POINTS);
-    glVertex2f(-0.03f, -0.05f);  // Left foot
-    glVertex2f(0.03f, -0.05f);   // Right foot
-    glEnd();
-
-    glPopMatrix();
+    batch.color(1.0f, 0.0f, 0.0f);  // Red feet
+    batch.pointSize(5.0f);  // Make points larger
+    batch.begin(GL_POINTS);
+    batch.vertex(-0.03f, -0.05f);  // Left foot
+    batch.vertex(0.03f, -0.05f);   // Right foot
+    batch.end();
+
+    batch.pop();
 }
 
 // Function to draw the first obstacle (on the ground) using 2 different primitives
 void drawGroundObstacle(float x) {
-    glPushMatrix();
-    glTranslatef(x, obstacleY, 0.0f);  // Obstacle's position
+    batch.push();
+    batch.translate(x, obstacleY);  // Obstacle's position
 
     // Primitive 1: Base (Quad)
-    glColor3f(1.0f, 0.0f, 0.0f);  // Red base
-    glBegin(GL_QUADS);
-    glVertex2f(-0.05f, -0.05f);
-    glVertex2f(0.05f, -0.05f);
-    glVertex2f(0.05f, 0.05f);
-    glVertex2f(-0.05f, 0.05f);
-    glEnd();
+    batch.color(1.0f, 0.0f, 0.0f);  // Red base
+    batch.begin(GL_QUADS);
+    batch.vertex(-0.05f, -0.05f);
+    batch.vertex(0.05f, -0.05f);
+    batch.vertex(0.05f, 0.05f);
+    batch.vertex(-0.05f, 0.05f);
+    batch.end();
 
     // Primitive 2: Top (Triangle)
-    glColor3f(0.0f, 1.0f, 1.0f);  // Cyan triangle on top
-    glBegin(GL_TRIANGLES);
-    glVertex2f(-0.03f, 0.05f);  // Top point
-    glVertex2f(0.03f, 0.05f);   // Bottom right
-    glVertex2f(0.0f, 0.1f);     // Bottom left
-    glEnd();
-
-    glPopMatrix();
+    batch.color(0.0f, 1.0f, 1.0f);  // Cyan triangle on top
+    batch.begin(GL_TRIANGLES);
+    batch.vertex(-0.03f, 0.05f);  // Top point
+    batch.vertex(0.03f, 0.05f);   // Bottom right
+    batch.vertex(0.0f, 0.1f);     // Bottom left
+    batch.end();
+
+    batch.pop();
 }
 
 // Function to draw the second obstacle (above the player's height) using 2 different primitives
 void drawAboveObstacle(float x) {
-    glPushMatrix();
-    glTranslatef(x, obstacleY + 0.2f, 0.0f);  // Positioned above player's height
+    batch.push();
+    batch.translate(x, obstacleY + 0.2f);  // Positioned above player's height
 
     // Primitive 1: Base (Polygon)
-    glColor3f(0.8f, 0.0f, 1.0f);  // Purple base
-    glBegin(GL_POLYGON);  // Hexagon shape
-    glVertex2f(0.0f, 0.0f);
-    glVertex2f(0.03f, 0.02f);
-    glVertex2f(0.05f, 0.05f);
-    glVertex2f(0.03f, 0.08f);
-    glVertex2f(0.0f, 0.1f);
-    glVertex2f(-0.03f, 0.08f);
-    glVertex2f(-0.05f, 0.05f);
-    glVertex2f(-0.03f, 0.02f);
-    glEnd();
+    batch.color(0.8f, 0.0f, 1.0f);  // Purple base
+    batch.begin(GL_POLYGON);  // Hexagon shape
+    batch.vertex(0.0f, 0.0f);
+    batch.vertex(0.03f, 0.02f);
+    batch.vertex(0.05f, 0.05f);
+    batch.vertex(0.03f, 0.08f);
+    batch.vertex(0.0f, 0.1f);
+    batch.vertex(-0.03f, 0.08f);
+    batch.vertex(-0.05f, 0.05f);
+    batch.vertex(-0.03f, 0.02f);
+    batch.end();
 
     // Primitive 2: Connecting Line
-    glColor3f(0.0f, 0.0f, 1.0f);  // Blue line connecting base to "ground"
-    glBegin(GL_LINES);
-    glVertex2f(0.0f, 0.0f);
-    glVertex2f(0.0f, -0.05f);  // Connect to below the obstacle
-    glEnd();
+    batch.color(0.0f, 0.0f, 1.0f);  // Blue line connecting base to "ground"
+    batch.begin(GL_LINES);
+    batch.vertex(0.0f, 0.0f);
+    batch.vertex(0.0f, -0.05f);  // Connect to below the obstacle
+    batch.end();
 
-    glPopMatrix();
+    batch.pop();
 }
 
 // Function to draw the collectible using 3 different primitives
 void drawCollectible(float x, float y) {
-    glPushMatrix();
-    glTranslatef(x, y, 0.0f);  // Collectible's position
-    glRotatef(rotationAngle, 0.0f, 1.0f, 0.0f);  // Rotate around the Z-axis
+    batch.push();
+    batch.translate(x, y);  // Collectible's position
+    batch.rotateY(rotationAngle);  // Rotate around the Z-axis
 
     // Primitive 1: Base (Quad)
-    glColor3f(1.0f, 0.5f, 0.0f);  // Orange base
-    glBegin(GL_QUADS);
-    glVertex2f(-0.03f, -0.03f);
-    glVertex2f(0.03f, -0.03f);
-    glVertex2f(0.03f, 0.03f);
-    glVertex2f(-0.03f, 0.03f);
-    glEnd();
+    batch.color(1.0f, 0.5f, 0.0f);  // Orange base
+    batch.begin(GL_QUADS);
+    batch.vertex(-0.03f, -0.03f);
+    batch.vertex(0.03f, -0.03f);
+    batch.vertex(0.03f, 0.03f);
+    batch.vertex(-0.03f, 0.03f);
+    batch.end();
 
     // Primitive 2: Top (Triangle)
-    glColor3f(0.0f, 1.0f, 0.0f);  // Green triangle on top
-    glBegin(GL_TRIANGLES);
-    glVertex2f(-0.02f, 0.03f);  // Bottom left
-    glVertex2f(0.02f, 0.03f);   // Bottom right
-    glVertex2f(0.0f, 0.06f);    // Top
-    glEnd();
+    batch.color(0.0f, 1.0f, 0.0f);  // Green triangle on top
+    batch.begin(GL_TRIANGLES);
+    batch.vertex(-0.02f, 0.03f);  // Bottom left
+    batch.vertex(0.02f, 0.03f);   // Bottom right
+    batch.vertex(0.0f, 0.06f);    // Top
+    batch.end();
 
     // Primitive 3: Center (Circle approximation with a polygon)
-    glColor3f(0.0f, 0.0f, 1.0f);  // Blue circle
-    glBegin(GL_POLYGON);
-    for (int i = 0; i < 20; i++) {
-        float theta = 2.0f * 3.14159f * float(i) / 20.0f;  // Angle for each segment
-        float dx = 0.01f * cosf(theta);  // X component
-        float dy = 0.01f * sinf(theta);  // Y component
-        glVertex2f(dx, dy);
-    }
-    glEnd();
+    batch.color(0.0f, 0.0f, 1.0f);  // Blue circle
+    batch.begin(GL_POLYGON);
+    batch.appendShape(shapes.circle20, 0.0f, 0.0f, 0.01f, 0.01f);
+    batch.end();
 
-    glPopMatrix();
+    batch.pop();
 }
 
 // Function to check for collision between player and collectible
@@ -377,13 +389,16 @@ bool checkCollectibleCollision() {
     return (distanceXCollectible < 0.1f && distanceYCollectible < 0.1f);  // Simple bounding box collision
 }
 
+const uint64_t collectibleSeed = 1;
+Random collectibleRng(collectibleSeed);  // Own generator instead of the shared rand() state
+
 // Function to randomly respawn collectibles, ensuring they do not overlap with obstacles
 void respawnCollectible() {
     int maxAttempts = 10;  // Maximum attempts to find a valid position
     int attempts = 0;
 
     // Random vertical position within reachable range (between -0.05 and 0.2)
-    float newY = ((rand() % 4) * 0.05f) - 0.05f;  // Possible values: -0.05, 0, 0.05, 0.10, 0.15
+    float newY = (collectibleRng.below(4) * 0.05f) - 0.05f;  // Possible values: -0.05, 0, 0.05, 0.10, 0.15
 
     // Respawn collectible with a new X position, ensuring it doesn't overlap with obstacles
     float newX;
@@ -403,38 +418,42 @@ void respawnCollectible() {
 
 
 
+// Helvetica 18 read back from GLUT on the first frame, and the strings drawn with it;
+// each is laid out again only when its text changes
+GlyphAtlas textFont;
+TextMesh scoreLabel;
+TextMesh timeLabel;
+TextMesh healthLabel;
+TextMesh messageLabel;  // GAME LOSE! / GAME END!
+
 void drawHUD() {
-    char hud[50];
-    sprintf(hud, "Score: %d", score);
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glRasterPos2f(-0.9f, 0.85f);
-    for (int i = 0; hud[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, hud[i]);
-    }
+    scoreLabel.setNumber(textFont, "Score: %d", score);
+    batch.color(1.0f, 1.0f, 1.0f);
+    scoreLabel.draw(batch, -0.9f, 0.85f);
 }
 
 // Function to draw one health unit (heart) using 2 primitives: quad and triangle
 void drawHealthUnit(float x, float y) {
-    glPushMatrix();
-    glTranslatef(x, y, 0.0f);  // Position the health unit
+    batch.push();
+    batch.translate(x, y);  // Position the health unit
 
     // Primitive 1: Bottom part (Triangle)
-    glColor3f(1.0f, 0.0f, 0.0f);  // Red color
-    glBegin(GL_TRIANGLES);
-    glVertex2f(-0.02f, 0.0f);   // Bottom left
-    glVertex2f(0.02f, 0.0f);    // Bottom right
-    glVertex2f(0.0f, 0.03f);    // Top
-    glEnd();
+    batch.color(1.0f, 0.0f, 0.0f);  // Red color
+    batch.begin(GL_TRIANGLES);
+    batch.vertex(-0.02f, 0.0f);   // Bottom left
+    batch.vertex(0.02f, 0.0f);    // Bottom right
+    batch.vertex(0.0f, 0.03f);    // Top
+    batch.end();
 
     // Primitive 2: Top part (Quad for round top)
-    glBegin(GL_QUADS);
-    glVertex2f(-0.015f, 0.03f);  // Bottom left
-    glVertex2f(0.015f, 0.03f);   // Bottom right
-    glVertex2f(0.015f, 0.045f);  // Top right
-    glVertex2f(-0.015f, 0.045f); // Top left
-    glEnd();
-
-    glPopMatrix();
+    batch.begin(GL_QUADS);
+    batch.vertex(-0.015f, 0.03f);  // Bottom left
+    batch.vertex(0.015f, 0.03f);   // Bottom right
+    batch.vertex(0.015f, 0.045f);  // Top right
+    batch.vertex(-0.015f, 0.045f); // Top left
+    batch.end();
+
+    batch.pop();
 }
 
 // Function to draw the player's health with multiple health units (hearts)
@@ -446,175 +465,146 @@ void drawHealth() {
 
 // Function to draw the remaining time on top of the screen
 void drawTimer(int remainingTime) {
-    char timeText[50];
-    sprintf(timeText, "Time: %d", remainingTime);  // Display remaining time
+    timeLabel.setNumber(textFont, "Time: %d", remainingTime);  // Display remaining time
 
-    glColor3f(1.0f, 1.0f, 1.0f);  // White text
-    glRasterPos2f(0.6f, 0.85f);  // Position text at the top-right corner
-    for (int i = 0; timeText[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, timeText[i]);
-    }
+    batch.color(1.0f, 1.0f, 1.0f);  // White text
+    timeLabel.draw(batch, 0.6f, 0.85f);  // Position text at the top-right corner
 }
 
 // Function to display Game Over message
 void displayGameOver() {
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glRasterPos2f(-0.2f, 0.0f);
-    const char* message = "GAME LOSE!";
-    for (int i = 0; message[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, message[i]);
-    }
+    batch.startFrame();
+    batch.color(1.0f, 0.0f, 0.0f);
+    messageLabel.set(textFont, "GAME LOSE!");
+    messageLabel.draw(batch, -0.2f, 0.0f);
 
-    char scoreMessage[50];
-    sprintf(scoreMessage, "Final Score: %d", score);
-    glRasterPos2f(-0.2f, -0.1f);
-    for (int i = 0; scoreMessage[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, scoreMessage[i]);
-    }
+    scoreLabel.setNumber(textFont, "Final Score: %d", score);
+    scoreLabel.draw(batch, -0.2f, -0.1f);
 
+    batch.flush();
     glutSwapBuffers();  // Swap buffers to display message
 }
 
 // Function to display Game Over message
 void displayGameEnd() {
-    glColor3f(0.0f, 0.0f, 1.0f);
-    glRasterPos2f(-0.2f, 0.0f);
-    const char* message = "GAME END!";
-    for (int i = 0; message[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, message[i]);
-    }
+    batch.startFrame();
+    batch.color(0.0f, 0.0f, 1.0f);
+    messageLabel.set(textFont, "GAME END!");
+    messageLabel.draw(batch, -0.2f, 0.0f);
 
-    char scoreMessage[50];
-    sprintf(scoreMessage, "Final Score: %d", score);
-    glRasterPos2f(-0.2f, -0.1f);
-    for (int i = 0; scoreMessage[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, scoreMessage[i]);
-    }
+    scoreLabel.setNumber(textFont, "Final Score: %d", score);
+    scoreLabel.draw(batch, -0.2f, -0.1f);
 
+    batch.flush();
     glutSwapBuffers();  // Swap buffers to display message
 }
 
 // Function to draw the ground line
 void drawGroundLine() {
-    glColor3f(1.0f, 1.0f, 1.0f);  // White line
-    glBegin(GL_LINES);
-    glVertex2f(-1.0f, obstacleY - 0.05f);  // Ground level where obstacles are
-    glVertex2f(1.0f, obstacleY - 0.05f);
-    glEnd();
+    batch.color(1.0f, 1.0f, 1.0f);  // White line
+    batch.begin(GL_LINES);
+    batch.vertex(-1.0f, obstacleY - 0.05f);  // Ground level where obstacles are
+    batch.vertex(1.0f, obstacleY - 0.05f);
+    batch.end();
 }
 
 // Function to draw the upper border with 4 different primitives
 void drawUpperBorder() {
-    glPushMatrix();
+    batch.push();
 
     // Primitive 1: Upper Line (Line strip)
-    glColor3f(1.0f, 1.0f, 1.0f);  // White color
-    glBegin(GL_LINE_STRIP);
-    glVertex2f(-1.0f, 0.95f);  // Left end
-    glVertex2f(1.0f, 0.95f);   // Right end
-    glEnd();
+    batch.color(1.0f, 1.0f, 1.0f);  // White color
+    batch.begin(GL_LINE_STRIP);
+    batch.vertex(-1.0f, 0.95f);  // Left end
+    batch.vertex(1.0f, 0.95f);   // Right end
+    batch.end();
 
     // Primitive 2: Small Quad blocks on the upper border
-    glColor3f(0.5f, 0.5f, 0.5f);  // Gray color
+    batch.color(0.5f, 0.5f, 0.5f);  // Gray color
     for (float x = -0.9f; x <= 0.9f; x += 0.2f) {
-        glBegin(GL_QUADS);
-        glVertex2f(x, 0.93f);      // Bottom left
-        glVertex2f(x + 0.1f, 0.93f); // Bottom right
-        glVertex2f(x + 0.1f, 0.95f); // Top right
-        glVertex2f(x, 0.95f);      // Top left
-        glEnd();
+        batch.begin(GL_QUADS);
+        batch.vertex(x, 0.93f);      // Bottom left
+        batch.vertex(x + 0.1f, 0.93f); // Bottom right
+        batch.vertex(x + 0.1f, 0.95f); // Top right
+        batch.vertex(x, 0.95f);      // Top left
+        batch.end();
     }
 
     // Primitive 3: Triangular spikes on the upper border
-    glColor3f(1.0f, 0.0f, 0.0f);  // Red color
+    batch.color(1.0f, 0.0f, 0.0f);  // Red color
     for (float x = -0.9f; x <= 0.9f; x += 0.2f) {
-        glBegin(GL_TRIANGLES);
-        glVertex2f(x + 0.05f, 0.95f); // Base center
-        glVertex2f(x, 0.97f);        // Left spike
-        glVertex2f(x + 0.1f, 0.97f); // Right spike
-        glEnd();
+        batch.begin(GL_TRIANGLES);
+        batch.vertex(x + 0.05f, 0.95f); // Base center
+        batch.vertex(x, 0.97f);        // Left spike
+        batch.vertex(x + 0.1f, 0.97f); // Right spike
+        batch.end();
     }
 
     // Primitive 4: Circle decorations on the upper border
-    glColor3f(0.0f, 1.0f, 0.0f);  // Green color
+    batch.color(0.0f, 1.0f, 0.0f);  // Green color
     for (float x = -0.8f; x <= 0.8f; x += 0.4f) {
-        glBegin(GL_POLYGON);  // Circle approximation using a polygon
-        for (int i = 0; i < 20; i++) {
-            float theta = 2.0f * 3.14159f * float(i) / 20.0f;
-            float dx = 0.02f * cosf(theta);  // X component
-            float dy = 0.02f * sinf(theta);  // Y component
-            glVertex2f(x + dx, 0.96f + dy);
-        }
-        glEnd();
+        batch.begin(GL_POLYGON);  // Circle approximation using a polygon
+        batch.appendShape(shapes.circle20, x, 0.96f, 0.02f, 0.02f);
+        batch.end();
     }
 
-    glPopMatrix();
+    batch.pop();
 }
 
 // Function to draw the lower border with 4 different primitives
 void drawLowerBorder() {
-    glPushMatrix();
+    batch.push();
 
     // Primitive 1: Lower Line (Line strip)
-    glColor3f(1.0f, 1.0f, 1.0f);  // White color
-    glBegin(GL_LINE_STRIP);
-    glVertex2f(-1.0f, -0.95f);  // Left end
-    glVertex2f(1.0f, -0.95f);   // Right end
-    glEnd();
+    batch.color(1.0f, 1.0f, 1.0f);  // White color
+    batch.begin(GL_LINE_STRIP);
+    batch.vertex(-1.0f, -0.95f);  // Left end
+    batch.vertex(1.0f, -0.95f);   // Right end
+    batch.end();
 
     // Primitive 2: Small Quad blocks on the lower border
-    glColor3f(0.5f, 0.5f, 0.5f);  // Gray color
+    batch.color(0.5f, 0.5f, 0.5f);  // Gray color
     for (float x = -0.9f; x <= 0.9f; x += 0.2f) {
-        glBegin(GL_QUADS);
-        glVertex2f(x, -0.95f);     // Bottom left
-        glVertex2f(x + 0.1f, -0.95f); // Bottom right
-        glVertex2f(x + 0.1f, -0.93f); // Top right
-        glVertex2f(x, -0.93f);     // Top left
-        glEnd();
+        batch.begin(GL_QUADS);
+        batch.vertex(x, -0.95f);     // Bottom left
+        batch.vertex(x + 0.1f, -0.95f); // Bottom right
+        batch.vertex(x + 0.1f, -0.93f); // Top right
+        batch.vertex(x, -0.93f);     // Top left
+        batch.end();
     }
 
     // Primitive 3: Triangular spikes on the lower border
-    glColor3f(1.0f, 0.0f, 0.0f);  // Red color
+    batch.color(1.0f, 0.0f, 0.0f);  // Red color
     for (float x = -0.9f; x <= 0.9f; x += 0.2f) {
-        glBegin(GL_TRIANGLES);
-        glVertex2f(x + 0.05f, -0.95f); // Base center
-        glVertex2f(x, -0.97f);        // Left spike
-        glVertex2f(x + 0.1f, -0.97f); // Right spike
-        glEnd();
+        batch.begin(GL_TRIANGLES);
+        batch.vertex(x + 0.05f, -0.95f); // Base center
+        batch.vertex(x, -0.97f);        // Left spike
+        batch.vertex(x + 0.1f, -0.97f); // Right spike
+        batch.end();
     }
 
     // Primitive 4: Circle decorations on the lower border
-    glColor3f(0.0f, 1.0f, 0.0f);  // Green color
+    batch.color(0.0f, 1.0f, 0.0f);  // Green color
     for (float x = -0.8f; x <= 0.8f; x += 0.4f) {
-        glBegin(GL_POLYGON);  // Circle approximation using a polygon
-        for (int i = 0; i < 20; i++) {
-            float theta = 2.0f * 3.14159f * float(i) / 20.0f;
-            float dx = 0.02f * cosf(theta);  // X component
-            float dy = 0.02f * sinf(theta);  // Y component
-            glVertex2f(x + dx, -0.96f + dy);
-        }
-        glEnd();
+        batch.begin(GL_POLYGON);  // Circle approximation using a polygon
+        batch.appendShape(shapes.circle20, x, -0.96f, 0.02f, 0.02f);
+        batch.end();
     }
 
-    glPopMatrix();
+    batch.pop();
 }
 
 // Function to draw a circle (background decoration)
 void drawCircle(float x, float y, float radius) {
-    glPushMatrix();
-    glTranslatef(x, y, 0.0f);  // Move to the circle's position
-    glColor3f(0.0f, 0.5f, 0.8f);  // Light blue color for the circle
-
-    glBegin(GL_POLYGON);  // Approximate circle using a polygon
-    for (int i = 0; i < 50; i++) {
-        float theta = 2.0f * 3.14159f * float(i) / 50.0f;  // Angle for each segment
-        float dx = radius * cosf(theta);  // X component
-        float dy = radius * sinf(theta);  // Y component
-        glVertex2f(dx, dy);
-    }
-    glEnd();
+    batch.push();
+    batch.translate(x, y);  // Move to the circle's position
+    batch.color(0.0f, 0.5f, 0.8f);  // Light blue color for the circle
 
-    glPopMatrix();
+    batch.begin(GL_POLYGON);  // Approximate circle using a polygon
+    batch.appendShape(shapes.circle50, 0.0f, 0.0f, radius, radius);  // 50 segments
+    batch.end();
+
+    batch.pop();
 }
 
 // Function to animate and draw the background circles
@@ -638,118 +628,105 @@ void drawPowerup1(float x, float y) {
     float size = 0.1f;
 
     float animationOffset = 0.03f * sinf(glutGet(GLUT_ELAPSED_TIME) / 500.0f);
-    glPushMatrix();
-    glTranslatef(0.0f, animationOffset, 0.0f);
+    batch.push();
+    batch.translate(0.0f, animationOffset);
 
     // Amount to translate the red part to the right
     float rectWidth = size * 0.7f; // Width of the red and white rectangles (equal to diameter of semicircles)
     float rectHeight = size * 0.5f; // Height for the small squares
 
     // Draw the left part (red semicircle)
-    glColor3f(1.0f, 0.5f, 0.0f); // Red color for the semicircle
-    glBegin(GL_POLYGON);
-    for (int i = 0; i <= 20; i++) {
-        // Adjust the angle for left-side semicircle (90 degrees to 270 degrees)
-        float theta = 3.14159f * (float(i) / 20.0f + 0.5f); // Sweep from 90 to 270 degrees
-
-        float cx = x; // Center of the left semicircle
-        float cy = y + rectHeight * 0.5f; // Center vertically (aligned with the small squares)
-
-        // Create vertices for the left semicircle
-        glVertex2f(cx + (rectHeight * 0.5f) * cosf(theta), cy + (rectHeight * 0.5f) * sinf(theta));
-    }
-    glEnd();
+    batch.color(1.0f, 0.5f, 0.0f); // Red color for the semicircle
+    batch.begin(GL_POLYGON);
+    // Centered on x, vertically aligned with the small squares; sweeps 90 to 270 degrees
+    batch.appendShape(shapes.leftHalf, x, y + rectHeight * 0.5f, rectHeight * 0.5f, rectHeight * 0.5f);
+    batch.end();
 
     // Draw the red square (in between the semicircles)
-    glColor3f(1.0f, 0.5f, 0.0f); // Red color for the square
-    glBegin(GL_QUADS);
-    glVertex2f(x, y);                    // Bottom-left
-    glVertex2f(x + rectWidth, y);        // Bottom-right
-    glVertex2f(x + rectWidth, y + rectHeight); // Top-right
-    glVertex2f(x, y + rectHeight);       // Top-left
-    glEnd();
+    batch.color(1.0f, 0.5f, 0.0f); // Red color for the square
+    batch.begin(GL_QUADS);
+    batch.vertex(x, y);                    // Bottom-left
+    batch.vertex(x + rectWidth, y);        // Bottom-right
+    batch.vertex(x + rectWidth, y + rectHeight); // Top-right
+    batch.vertex(x, y + rectHeight);       // Top-left
+    batch.end();
 
     // Draw the white square (in between the semicircles)
-    glColor3f(1.0, 1.0, 1.0); // White color for the square
-    glBegin(GL_QUADS);
-    glVertex2f(x + rectWidth, y);                    // Bottom-left
-    glVertex2f(x + rectWidth * 2.0f, y);             // Bottom-right
-    glVertex2f(x + rectWidth * 2.0f, y + rectHeight); // Top-right
-    glVertex2f(x + rectWidth, y + rectHeight);       // Top-left
-    glEnd();
+    batch.color(1.0, 1.0, 1.0); // White color for the square
+    batch.begin(GL_QUADS);
+    batch.vertex(x + rectWidth, y);                    // Bottom-left
+    batch.vertex(x + rectWidth * 2.0f, y);             // Bottom-right
+    batch.vertex(x + rectWidth * 2.0f, y + rectHeight); // Top-right
+    batch.vertex(x + rectWidth, y + rectHeight);       // Top-left
+    batch.end();
 
     // Draw the right part (white semicircle)
-    glColor3f(1.0, 1.0, 1.0); // White color for the semicircle
-    glBegin(GL_POLYGON);
-    for (int i = 0; i <= 20; i++) {
-        // Adjust the angle for right-side semicircle (270 degrees to 450 degrees)
-        float theta = 3.14159f * (float(i) / 20.0f - 0.5f); // Sweep from 270 to 450 degrees
-
-        float cx = x + rectWidth * 2.0f; // Center of the right semicircle
-        float cy = y + rectHeight * 0.5f; // Center vertically (aligned with the small squares)
+    batch.color(1.0, 1.0, 1.0); // White color for the semicircle
+    batch.begin(GL_POLYGON);
+    // Centered on the right edge of the white square; sweeps 270 to 450 degrees
+    batch.appendShape(shapes.rightHalf, x + rectWidth * 2.0f, y + rectHeight * 0.5f, rectHeight * 0.5f, rectHeight * 0.5f);
+    batch.end();
 
-        // Create vertices for the right semicircle
-        glVertex2f(cx + (rectHeight * 0.5f) * cosf(theta), cy + (rectHeight * 0.5f) * sinf(theta));
-    }
-    glEnd();
-
-    glPopMatrix();
+    batch.pop();
 }
 
 // Function to draw Power-Up 2 (Slow-Motion) using 4 different primitives
 void drawPowerup2(float x, float y) {
     float animationOffset = 0.03f * sinf(glutGet(GLUT_ELAPSED_TIME) / 500.0f);
-    glPushMatrix();
-    glTranslatef(0.0f, animationOffset, 0.0f);
+    batch.push();
+    batch.translate(0.0f, animationOffset);
 
     float size = 0.1f;
     // Draw a yellow lightning bolt for speed power-up
-    glColor3f(0.5f, 1.0f, 1.0f); // Cyan color for the lightning bolt
+    batch.color(0.5f, 1.0f, 1.0f); // Cyan color for the lightning bolt
 
     // First right-angled triangle (top)
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x, y + size); // Top vertex (at the top of the bolt)
-    glVertex2f(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
-    glVertex2f(x, y + size * 0.5f); // Mid-left vertex
-    glEnd();
+    batch.begin(GL_TRIANGLES);
+    batch.vertex(x, y + size); // Top vertex (at the top of the bolt)
+    batch.vertex(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
+    batch.vertex(x, y + size * 0.5f); // Mid-left vertex
+    batch.end();
 
     // Second right-angled triangle (bottom, flipped to the left)
     float shiftAmount = 0.025f; // Amount to shift the bottom triangle to the left
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x + size * 0.5f - shiftAmount, y);           // Bottom-right vertex (shifted left)
-    glVertex2f(x - shiftAmount, y + size * 0.5f);           // Tip of the bottom triangle (pointing left)
-    glVertex2f(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex (shared with the top triangle, shifted left)
-    glEnd();
+    batch.begin(GL_TRIANGLES);
+    batch.vertex(x + size * 0.5f - shiftAmount, y);           // Bottom-right vertex (shifted left)
+    batch.vertex(x - shiftAmount, y + size * 0.5f);           // Tip of the bottom triangle (pointing left)
+    batch.vertex(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex (shared with the top triangle, shifted left)
+    batch.end();
 
     // Draw a line between both triangles
-    glColor3f(1.0, 1.0, 1.0); // White color for the line
-    glBegin(GL_LINES);
-    glVertex2f(x + size * 0.25f, y + size * 0.5f); // Start at the tip of the top triangle
-    glVertex2f(x + size * 0.25f, y);         // Draw a line down to the base of the bottom triangle
-    glEnd();
+    batch.color(1.0, 1.0, 1.0); // White color for the line
+    batch.begin(GL_LINES);
+    batch.vertex(x + size * 0.25f, y + size * 0.5f); // Start at the tip of the top triangle
+    batch.vertex(x + size * 0.25f, y);         // Draw a line down to the base of the bottom triangle
+    batch.end();
 
     // Draw outline for the top triangle
-    glColor3f(1.0, 1.0, 1.0); // White color for outline
-    glBegin(GL_LINE_LOOP); // Outline for the top triangle
-    glVertex2f(x, y + size); // Top vertex
-    glVertex2f(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
-    glVertex2f(x, y + size * 0.5f); // Mid-left vertex
-    glEnd();
+    batch.color(1.0, 1.0, 1.0); // White color for outline
+    batch.begin(GL_LINE_LOOP); // Outline for the top triangle
+    batch.vertex(x, y + size); // Top vertex
+    batch.vertex(x + size * 0.5f, y + size * 0.5f); // Mid-right vertex
+    batch.vertex(x, y + size * 0.5f); // Mid-left vertex
+    batch.end();
 
     // Draw outline for the bottom triangle
-    glBegin(GL_LINE_LOOP); // Outline for the bottom triangle
-    glVertex2f(x + size * 0.5f - shiftAmount, y); // Bottom-right vertex (shifted left)
-    glVertex2f(x - shiftAmount, y + size * 0.5f); // Tip of the bottom triangle (pointing left)
-    glVertex2f(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex
-    glEnd();
+    batch.begin(GL_LINE_LOOP); // Outline for the bottom triangle
+    batch.vertex(x + size * 0.5f - shiftAmount, y); // Bottom-right vertex (shifted left)
+    batch.vertex(x - shiftAmount, y + size * 0.5f); // Tip of the bottom triangle (pointing left)
+    batch.vertex(x + size * 0.5f - shiftAmount, y + size * 0.5f); // Base vertex
+    batch.end();
 
-    glPopMatrix();
+    batch.pop();
 }
 
 
 
 // Function to update the display
 void display() {
+    if (!textFont.built()) {  // Read back through the frame buffer, so before this frame is drawn
+        textFont.build(GLUT_BITMAP_HELVETICA_18);
+    }
     glClear(GL_COLOR_BUFFER_BIT);  // Clear the screen
 
     playBackgroundMusic();
@@ -766,15 +743,21 @@ void display() {
         return;             // Stop drawing game elements
     }
 
-    // Draw and animate the background circles
-    updateBackground();
+    batch.startFrame();
 
-    // Draw the upper and lower borders
-    drawUpperBorder();
-    drawLowerBorder();
+    // Draw the upper and lower borders and the ground line. They never change, so
+    // they are recorded once and replayed; nothing that moves overlaps them, so
+    // they can go before the circles.
+    if (borderLayer.needsRecording()) {
+        drawUpperBorder();
+        drawLowerBorder();
+        drawGroundLine();
+        borderLayer.capture(batch);
+    }
+    borderLayer.draw();
 
-    // Draw the ground line
-    drawGroundLine();
+    // Draw and animate the background circles
+    updateBackground();
 
     // Draw the player with 4 different primitives
     drawPlayer();
@@ -787,11 +770,9 @@ void display() {
     drawCollectible(collectibleX, collectibleY);  // Draw collectible at current position
 
     // Display "Health: " label before the health hearts
-    glRasterPos2f(-0.9f, 0.75f);  // Position the label a bit lower
-    const char* healthText = "Health: ";
-    for (int i = 0; healthText[i] != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, healthText[i]);
-    }
+    batch.color(0.0f, 0.0f, 1.0f);  // Blue, the color the collectible used to leave behind
+    healthLabel.set(textFont, "Health: ");
+    healthLabel.draw(batch, -0.9f, 0.75f);  // Position the label a bit lower
 
     // Draw the player's health as hearts
     drawHealth();  // Replaces the numeric health display
@@ -810,6 +791,7 @@ void display() {
         drawPowerup2(powerUp2X, 0.2f);  // Draw Power-Up 2 at its position
     }
 
+    batch.flush();
     glutSwapBuffers();  // Swap buffers for animation
 }
 
@@ -851,11 +833,52 @@ bool checkPowerup2Collision() {
 }
 
 
+// Input log: every arrow key event tagged with the update frame it arrived in
+const char* INPUT_LOG_PATH = "source1_input.replay";
+Replay inputLog;
+uint32_t frameCount = 0;  // update() calls so far
+bool inputLogSaved = false;
+
+void saveInputLog() {
+    if (!inputLogSaved) {
+        inputLog.seed = collectibleSeed;
+        inputLog.dt = 0.016f;
+        inputLog.ticks = frameCount;
+        inputLog.save(INPUT_LOG_PATH);
+        inputLogSaved = true;
+    }
+}
+
+// Power-ups end at a fixed game time; an overdue end fires on the next update
+void schedulePowerUpEnd(uint8_t kind, float endTime) {
+    uint64_t due = timerBucket(endTime);
+    Timer t = { due > 0 ? due - 1 : 0, endTime, 0, kind };  // A bucket early, the handler checks the exact time
+    powerUpTimers.schedule(t);
+}
+
+bool firePowerUpTimer(const Timer& t) {
+    if (elapsedTime < t.stamp) {
+        return false;  // Not quite there yet, try again next bucket
+    }
+    if (t.kind == TIMER_POWERUP1_END && powerUp1Active) {
+        powerUp1Active = false;
+    }
+    else if (t.kind == TIMER_POWERUP2_END && powerUp2Active) {
+        powerUp2Active = false;
+        speedMultiplier = oldSpeedMultiplier;
+    }
+    return true;
+}
+
 // Timer function to update the game state
 void update(int value) {
+    if (isGameOver || isGameEnd) {
+        saveInputLog();
+    }
     if (isGameOver) {
         return;  // Stop updating if the game is over
     }
+    frameCount++;
 
     // Increment elapsed time
     elapsedTime += 0.016f;  // Assuming 60 FPS, so approx. 1/60th of a second per frame
@@ -975,6 +998,7 @@ void update(int value) {
             powerUp1X = -2.0f;
             powerUp1Spawned = false;
             powerUp1Active = true;
+            schedulePowerUpEnd(TIMER_POWERUP1_END, 20.0f);
         }
     }
 
@@ -985,6 +1009,7 @@ void update(int value) {
             powerUp2Active = true;
             oldSpeedMultiplier = speedMultiplier;
             speedMultiplier = 1.0f;
+            schedulePowerUpEnd(TIMER_POWERUP2_END, 50.0f);
         }
     }
 
@@ -998,14 +1023,7 @@ void update(int value) {
         powerUp2Spawned = true;  // Spawn Power-Up 2 after 40 seconds
     }
 
-    if (powerUp1Active && elapsedTime >= 20.0f) {
-        powerUp1Active = false;
-    }
-
-    if (powerUp2Active && elapsedTime >= 50.0f) {
-        powerUp2Active = false;
-        speedMultiplier = oldSpeedMultiplier;
-    }
+    powerUpTimers.advance(timerBucket(elapsedTime), firePowerUpTimer);
 
     // Redraw the scene
     glutPostRedisplay();
@@ -1014,6 +1032,9 @@ void update(int value) {
 
 // Input handling for special keys (Arrow keys)
 void specialInput(int key, int x, int y) {
+    if (key == GLUT_KEY_UP || key == GLUT_KEY_DOWN) {
+        inputLog.record(frameCount, key == GLUT_KEY_UP ? INPUT_JUMP : INPUT_DUCK);
+    }
     if (key == GLUT_KEY_UP && !isJumping && !isGameOver) {
         // Start the jump
         isJumping = true;
@@ -1028,6 +1049,9 @@ void specialInput(int key, int x, int y) {
 
 // Handle key release for ducking
 void specialInputUp(int key, int x, int y) {
+    if (key == GLUT_KEY_UP || key == GLUT_KEY_DOWN) {
+        inputLog.record(frameCount, (key == GLUT_KEY_UP ? INPUT_JUMP : INPUT_DUCK) | INPUT_RELEASE);
+    }
     if (key == GLUT_KEY_DOWN && !isGameOver) {
         // Stop ducking, return to initial position
         //playerY = 0.0f;
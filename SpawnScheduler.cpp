@@ -0,0 +1,79 @@
+#include "SpawnScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+
+// Heap comparator: true if a should pop after b
+static bool later(const SpawnEvent& a, const SpawnEvent& b) {
+	if (a.key != b.key) {
+		return a.key > b.key;
+	}
+	if (a.lane != b.lane) {
+		return a.lane > b.lane;
+	}
+	return a.seq > b.seq;
+}
+
+SpawnScheduler::SpawnScheduler() {
+	clear();
+}
+
+void SpawnScheduler::clear() {
+	events.clear();
+	for (int l = 0; l < SPAWN_LANES; l++) {
+		lastSpawn[l] = -std::numeric_limits<float>::infinity();
+	}
+	offset = 0.0f;
+	paused = false;
+	nextSeq = 0;
+}
+
+void SpawnScheduler::schedule(int lane, float time) {
+	SpawnEvent e = { time - offset, nextSeq++, static_cast<uint8_t>(lane) };
+	events.push_back(e);
+	std::push_heap(events.begin(), events.end(), later);
+}
+
+bool SpawnScheduler::popDue(float now, int& lane) {
+	while (!paused && !events.empty() && events.front().key + offset <= now) {
+		SpawnEvent e = events.front();
+		std::pop_heap(events.begin(), events.end(), later);
+		events.pop_back();
+
+		// Too close behind another lane's spawn: wait out the gap
+		float earliest = -std::numeric_limits<float>::infinity();
+		for (int l = 0; l < SPAWN_LANES; l++) {
+			if (l != e.lane) {
+				earliest = std::max(earliest, lastSpawn[l] + separation[e.lane]);
+			}
+		}
+		if (earliest > now) {
+			schedule(e.lane, earliest);
+			continue;
+		}
+
+		lastSpawn[e.lane] = now;
+		lane = e.lane;
+		return true;
+	}
+	return false;
+}
+
+void SpawnScheduler::shift(float seconds) {
+	offset += seconds;
+}
+
+void SpawnScheduler::pause(float now) {
+	if (!paused) {
+		paused = true;
+		pausedAt = now;
+	}
+}
+
+void SpawnScheduler::resume(float now) {
+	if (paused) {
+		paused = false;
+		shift(now - pausedAt);
+	}
+}
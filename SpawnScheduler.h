@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Timeline of upcoming spawns: a binary min-heap of events ordered by due time,
+// then lane, then scheduling order, so equal times always resolve the same way.
+// Scheduling is O(log n), and popDue() only pops once the earliest event is due.
+//
+// Each lane keeps a minimum separation from the spawns of the other lanes: an
+// event that comes due too soon after another lane spawned is pushed back to the
+// end of that gap instead of spawning on top of it. Ties go to the lower lane.
+//
+// shift() delays every pending event at once in O(1): events are stored relative
+// to a running offset, and shifting only moves the offset.
+
+enum SpawnLane {
+	LANE_OBSTACLE = 0,
+	LANE_COLLECTABLE = 1,
+	LANE_POWERUP = 2,
+	SPAWN_LANES = 3
+};
+
+struct SpawnEvent {
+	float key;    // Due time minus the scheduler's offset
+	uint32_t seq; // Scheduling order, breaks ties between equal keys
+	uint8_t lane;
+};
+
+class SpawnScheduler {
+public:
+	float separation[SPAWN_LANES] = { 0.5f, 0.5f, 0.5f }; // Seconds a lane waits after another lane spawned
+	float lastSpawn[SPAWN_LANES];  // Time each lane last spawned
+	float offset = 0.0f;           // Added to every key; see shift()
+	float pausedAt = 0.0f;
+	bool paused = false;
+	uint32_t nextSeq = 0;
+	std::vector<SpawnEvent> events; // Heap order
+
+	SpawnScheduler();
+
+	void clear(); // Drop every event and forget the last spawns; separations are kept
+	void schedule(int lane, float time);
+	bool popDue(float now, int& lane); // The next event due by now, after separation deferrals
+	size_t pending() const { return events.size(); }
+
+	void shift(float seconds); // Delay every pending event
+	void pause(float now);     // Nothing comes due until resume()
+	void resume(float now);    // Delays every pending event by the time spent paused
+};
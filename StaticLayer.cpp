@@ -0,0 +1,81 @@
+#include "StaticLayer.h"
+
+#include "GLBuffers.h"
+
+
+StaticLayer::StaticLayer()
+	: buffer(0), list(0), recordedWidth(0), recordedHeight(0) {
+}
+
+StaticLayer::~StaticLayer() {
+	if (buffer != 0) {
+		bufferApi()->deleteBuffers(1, &buffer);
+	}
+	if (list != 0) {
+		glDeleteLists(list, 1);
+	}
+}
+
+bool StaticLayer::needsRecording() const {
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	return recordedWidth == 0 || viewport[2] != recordedWidth || viewport[3] != recordedHeight;
+}
+
+void StaticLayer::capture(BatchRenderer& batch) {
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	recordedWidth = viewport[2];
+	recordedHeight = viewport[3];
+	vertexCount = batch.vertices.size();
+	const char* data = reinterpret_cast<const char*>(batch.vertices.data());
+
+	const BufferApi* gl = allowBuffers ? bufferApi() : nullptr;
+	if (gl && buffer == 0) {
+		gl->genBuffers(1, &buffer);
+	}
+	if (gl && buffer != 0) {
+		gl->bindBuffer(GL_ARRAY_BUFFER, buffer);
+		gl->bufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(vertexCount * sizeof(BatchVertex)), data, GL_STATIC_DRAW);
+		gl->bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else {
+		// Arrays are read when the list is compiled, so the list keeps its own copy
+		if (list == 0) {
+			list = glGenLists(1);
+		}
+		glNewList(list, GL_COMPILE);
+		BatchRenderer::drawArrays(data, vertexCount);
+		glEndList();
+	}
+	batch.vertices.clear();
+}
+
+void StaticLayer::draw(const GLfloat* matrix) {
+	if (vertexCount == 0) {
+		return;
+	}
+	GLint matrixMode = GL_MODELVIEW;
+	if (matrix) {
+		glGetIntegerv(GL_MATRIX_MODE, &matrixMode); // The games leave the projection selected
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		glMultMatrixf(matrix);
+	}
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (buffer != 0) {
+		const BufferApi* gl = bufferApi();
+		gl->bindBuffer(GL_ARRAY_BUFFER, buffer);
+		BatchRenderer::drawArrays(nullptr, vertexCount);
+		gl->bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else {
+		glCallList(list);
+	}
+	glDisable(GL_BLEND);
+	if (matrix) {
+		glPopMatrix();
+		glMatrixMode(matrixMode);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+#include "BatchRenderer.h"
+
+// Geometry that never changes, recorded once through a BatchRenderer and then
+// replayed with one call per frame. The recorded triangles go into a
+// GL_STATIC_DRAW vertex buffer where the context has them, or into a display
+// list on older GL, so a replay sends no vertex data at all. draw() can take a
+// matrix for the replay, which moves or shears the layer as a whole without
+// re-recording it.
+//
+// Lines and points are widened to pixels when recorded, so a layer records
+// again when the viewport size changes (see needsRecording()).
+
+class StaticLayer {
+public:
+	size_t vertexCount = 0;  // Triangles' vertices in the layer
+	bool allowBuffers = true; // False records into a display list instead
+
+	StaticLayer();
+	~StaticLayer();
+
+	// True before the first capture and after the viewport has been resized since
+	bool needsRecording() const;
+
+	// Takes everything appended to the batch since its last flush as this layer's
+	// content, replacing any earlier recording; the batch is left empty
+	void capture(BatchRenderer& batch);
+
+	// Blended, like BatchRenderer::flush(). matrix is a column-major 4x4
+	// multiplied onto the modelview for this draw only.
+	void draw(const GLfloat* matrix = nullptr);
+
+private:
+	GLuint buffer; // Vertex buffer, or 0
+	GLuint list;   // Display list, or 0
+	GLint recordedWidth, recordedHeight; // Viewport of the last capture
+};
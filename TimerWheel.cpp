@@ -0,0 +1,79 @@
+#include "TimerWheel.h"
+
+
+void TimerWheel::schedule(const Timer& timer) {
+	count++;
+	if (timer.due <= cursor) {
+		overdue.push_back(timer);
+		return;
+	}
+	place(timer);
+}
+
+// File a future timer at the lowest level whose span still reaches its bucket
+void TimerWheel::place(const Timer& timer) {
+	uint64_t delta = timer.due - cursor;
+	for (int level = 0; level < LEVELS; level++) {
+		int shift = SLOT_BITS * level;
+		if (delta < (uint64_t(1) << (shift + SLOT_BITS)) || level == LEVELS - 1) {
+			uint64_t due = timer.due;
+			if (level == LEVELS - 1 && delta >= (uint64_t(1) << (shift + SLOT_BITS))) {
+				due = cursor + (uint64_t(1) << (shift + SLOT_BITS)) - 1; // Beyond the wheel: park in the farthest slot, re-filed when it cascades
+			}
+			slots[level][(due >> shift) & (SLOTS - 1)].push_back(timer);
+			return;
+		}
+	}
+}
+
+// The cursor just moved to a new bucket: every level whose boundary it crossed
+// hands its current slot down, highest first so the lower slots see everything
+void TimerWheel::cascade() {
+	int top = 0;
+	while (top + 1 < LEVELS && (cursor & ((uint64_t(1) << (SLOT_BITS * (top + 1))) - 1)) == 0) {
+		top++;
+	}
+	for (int level = top; level >= 1; level--) {
+		std::vector<Timer>& slot = slots[level][(cursor >> (SLOT_BITS * level)) & (SLOTS - 1)];
+		if (slot.empty()) {
+			continue;
+		}
+		firing.swap(slot);
+		for (size_t i = 0; i < firing.size(); i++) {
+			if (firing[i].due <= cursor) {
+				slots[0][cursor & (SLOTS - 1)].push_back(firing[i]); // Due now; fired right after the cascade
+			}
+			else {
+				place(firing[i]);
+			}
+		}
+		firing.clear();
+		if (slot.empty()) {
+			slot.swap(firing);
+		}
+	}
+}
+
+void TimerWheel::clear() {
+	for (int level = 0; level < LEVELS; level++) {
+		for (int s = 0; s < SLOTS; s++) {
+			slots[level][s].clear();
+		}
+	}
+	overdue.clear();
+	count = 0;
+}
+
+void TimerWheel::reset(uint64_t bucket) {
+	clear();
+	cursor = bucket;
+}
+
+void TimerWheel::collect(std::vector<Timer>& out) const {
+	out.insert(out.end(), overdue.begin(), overdue.end());
+	for (int level = 0; level < LEVELS; level++) {
+		for (int s = 0; s < SLOTS; s++) {
+			out.insert(out.end(), slots[level][s].begin(), slots[level][s].end());
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timer wheel: effects schedule their own expiry instead of every
+// tick polling every entity, so a tick costs only the timers that come due.
+// Time is counted in buckets of TIMER_QUANTUM seconds. Level 0 has one slot per
+// bucket for the next 64 buckets, and each level above covers 64 times the span
+// of the one below; when the cursor crosses a level boundary, the timers of the
+// next slot up cascade down to their exact level. Four levels reach ~72 hours.
+//
+// Timers are plain data and dispatched by kind, so the wheel can be walked and
+// saved in a snapshot. A handler that finds its precise condition not quite met
+// yet (bucket times are rounded) returns false and is re-armed for the next bucket.
+
+const float TIMER_QUANTUM = 1.0f / 64.0f;
+
+struct Timer {
+	uint64_t due;    // Bucket it fires in
+	float stamp;     // Owner-defined; typically the start time, to recognise stale timers
+	uint32_t target; // Owner-defined; e.g. an entity slot
+	uint8_t kind;    // Owner-defined dispatch key
+};
+
+inline uint64_t timerBucket(float seconds) {
+	return seconds > 0.0f ? static_cast<uint64_t>(seconds / TIMER_QUANTUM) : 0;
+}
+
+class TimerWheel {
+public:
+	static const int LEVELS = 4;
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = 1 << SLOT_BITS;
+
+	void schedule(const Timer& timer); // A due bucket at or before now() fires on the next advance()
+	void clear();
+	void reset(uint64_t bucket); // Empty wheel with the cursor at bucket
+
+	uint64_t now() const { return cursor; }
+	size_t pending() const { return count; }
+	void collect(std::vector<Timer>& out) const; // Append every pending timer, in no particular order
+
+	// Move the cursor to bucket `to`, calling fire(Timer&) for every timer that
+	// comes due; fire returns false to be re-armed for the next bucket
+	template <typename Fire>
+	void advance(uint64_t to, Fire fire) {
+		fireList(overdue, fire);
+		while (cursor < to) {
+			cursor++;
+			cascade();
+			fireList(slots[0][cursor & (SLOTS - 1)], fire);
+		}
+	}
+
+private:
+	std::vector<Timer> slots[LEVELS][SLOTS];
+	std::vector<Timer> overdue; // Scheduled at or before the cursor
+	std::vector<Timer> firing;  // Scratch so handlers can schedule while a list is walked
+	uint64_t cursor = 0;
+	size_t count = 0;
+
+	void place(const Timer& timer);
+	void cascade();
+
+	template <typename Fire>
+	void fireList(std::vector<Timer>& list, Fire fire) {
+		if (list.empty()) {
+			return;
+		}
+		firing.swap(list);
+		count -= firing.size();
+		for (size_t i = 0; i < firing.size(); i++) {
+			Timer t = firing[i];
+			if (!fire(t)) {
+				t.due = cursor + 1;
+				schedule(t);
+			}
+		}
+		firing.clear();
+		if (list.empty()) {
+			list.swap(firing); // Keep the larger allocation in the slot
+		}
+	}
+};
@@ -0,0 +1,104 @@
+#include "Tween.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Coefficients (c1, c2, c3) per TweenEase
+static const float EASE_COEFFICIENTS[EASE_COUNT][3] = {
+	{ 1.0f, 0.0f, 0.0f },  // Linear
+	{ 0.0f, 1.0f, 0.0f },  // In: t^2
+	{ 2.0f, -1.0f, 0.0f }, // Out: 2t - t^2
+	{ 0.0f, 3.0f, -2.0f }  // Smoothstep
+};
+
+void TweenSystem::add(uint16_t k, uint32_t t, float fromValue, float toValue, float startTime, float duration,
+	TweenEase ease, unsigned char flags) {
+	start.push_back(startTime);
+	invDuration.push_back(1.0f / duration);
+	from.push_back(fromValue);
+	delta.push_back(toValue - fromValue);
+	c1.push_back(EASE_COEFFICIENTS[ease][0]);
+	c2.push_back(EASE_COEFFICIENTS[ease][1]);
+	c3.push_back(EASE_COEFFICIENTS[ease][2]);
+	pingPong.push_back((flags & TWEEN_PINGPONG) ? 1.0f : 0.0f);
+	loop.push_back((flags & TWEEN_LOOP) ? 1.0f : 0.0f);
+	kind.push_back(k);
+	target.push_back(t);
+	value.push_back(fromValue);
+	done.push_back(0);
+}
+
+void TweenSystem::cancel(uint16_t k, uint32_t t) {
+	for (size_t i = 0; i < count(); ) {
+		if (kind[i] == k && target[i] == t) {
+			removeAt(i);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+void TweenSystem::clear() {
+	resize(0);
+}
+
+void TweenSystem::resize(size_t n) {
+	start.resize(n); invDuration.resize(n);
+	from.resize(n); delta.resize(n);
+	c1.resize(n); c2.resize(n); c3.resize(n);
+	pingPong.resize(n); loop.resize(n);
+	kind.resize(n); target.resize(n);
+	value.resize(n); done.resize(n);
+}
+
+void TweenSystem::evaluate(float time) {
+	const float* ps = start.data();
+	const float* pi = invDuration.data();
+	const float* pf = from.data();
+	const float* pd = delta.data();
+	const float* p1 = c1.data();
+	const float* p2 = c2.data();
+	const float* p3 = c3.data();
+	const float* pp = pingPong.data();
+	const float* pl = loop.data();
+	float* pv = value.data();
+	unsigned char* pdone = done.data();
+	size_t n = count();
+
+	for (size_t i = 0; i < n; i++) {
+		float e = (time - ps[i]) * pi[i];
+		float clamped = std::min(std::max(e, 0.0f), 1.0f);
+		float wrapped = e - static_cast<float>(static_cast<int>(e)); // Loops have e >= 0, so truncation is floor
+		float t = clamped + pl[i] * (wrapped - clamped);
+		float mirrored = 1.0f - std::abs(2.0f * t - 1.0f);
+		t += pp[i] * (mirrored - t);
+		float eased = ((p3[i] * t + p2[i]) * t + p1[i]) * t;
+		pv[i] = pf[i] + pd[i] * eased;
+		pdone[i] = (e >= 1.0f) & (pl[i] == 0.0f);
+	}
+}
+
+void TweenSystem::retireDone() {
+	for (size_t i = 0; i < count(); ) {
+		if (done[i]) {
+			removeAt(i);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+// Swap with the last entry and pop
+void TweenSystem::removeAt(size_t i) {
+	size_t last = count() - 1;
+	start[i] = start[last]; invDuration[i] = invDuration[last];
+	from[i] = from[last]; delta[i] = delta[last];
+	c1[i] = c1[last]; c2[i] = c2[last]; c3[i] = c3[last];
+	pingPong[i] = pingPong[last]; loop[i] = loop[last];
+	kind[i] = kind[last]; target[i] = target[last];
+	value[i] = value[last]; done[i] = done[last];
+	resize(last);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays tweens: every active animation is one entry across a set
+// of columns, and evaluate() computes all of them in a single branch-free pass
+// that the compiler vectorizes. Owners identify what a tween drives by a kind
+// and a handle (e.g. an entity slot) and write the values back themselves, so
+// the system knows nothing about players or obstacles.
+//
+// Easing curves are cubic polynomials e(t) = ((c3 t + c2) t + c1) t with
+// e(0) = 0 and e(1) = 1, stored per tween so the pass needs no table lookups.
+
+enum TweenEase : unsigned char {
+	EASE_LINEAR,
+	EASE_IN_QUAD,
+	EASE_OUT_QUAD,
+	EASE_SMOOTH, // Smoothstep, 3t^2 - 2t^3
+	EASE_COUNT
+};
+
+// Tween flag bits
+const unsigned char TWEEN_PINGPONG = 1 << 0; // Out to the end value and back over one duration
+const unsigned char TWEEN_LOOP = 1 << 1;     // Repeats forever and never finishes; must start at or before now
+
+class TweenSystem {
+public:
+	// One entry per active tween, in no particular order
+	std::vector<float> start, invDuration;
+	std::vector<float> from, delta;
+	std::vector<float> c1, c2, c3;
+	std::vector<float> pingPong, loop; // Flags as 0 / 1, blended rather than branched on
+	std::vector<uint16_t> kind;
+	std::vector<uint32_t> target;
+
+	// Written by evaluate()
+	std::vector<float> value;
+	std::vector<unsigned char> done;
+
+	size_t count() const { return start.size(); }
+	void add(uint16_t kind, uint32_t target, float from, float to, float startTime, float duration,
+		TweenEase ease, unsigned char flags = 0);
+	void cancel(uint16_t kind, uint32_t target); // Drop the tweens driving this target
+	void clear();
+
+	void evaluate(float time); // value and done for every tween
+	void retireDone();         // Drop the tweens evaluate() marked done; reorders the rest
+	void resize(size_t n);     // Every column to n entries, e.g. before filling them from a snapshot
+
+private:
+	void removeAt(size_t i);
+};